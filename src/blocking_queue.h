@@ -2,68 +2,110 @@
 #define BLOCKING_QUEUE_H
 
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+
+#include "thread_stats.h"
 /** 
 thread safe blocking queue. perfect for worker threads in a thread pool.
 blocking queue pulled from:
 http://codereview.stackexchange.com/questions/39199/multi-producer-consumer-queue-without-boost-in-c11?rq=1
+
+the size, high water mark and push timeouts are mirrored in atomics while the
+lock is held, so the stats thread can read them without taking it.
 */
 template<typename T>
 class blocking_queue {
 public:
     typedef std::queue<T> queue_t;
     typedef typename queue_t::size_type  size_type;
-    blocking_queue(){_max_size=100;}
-    explicit blocking_queue(std::size_t max_size) :_max_size(max_size), _q()
+    blocking_queue() : blocking_queue(100) {}
+    explicit blocking_queue(std::size_t max_size) :_max_size(max_size), _q(), _size(0), _high_water(0), _push_timeouts(0)
     {}
     blocking_queue(const blocking_queue&) = delete;
     blocking_queue& operator=(const blocking_queue&) = delete;
     ~blocking_queue() = default;
 
+    //Lock-free: may be stale by the time it returns
     size_type size()
     {
-        std::lock_guard<std::mutex> lock(_mutex);
-        return _q.size();
+        return _size.load(std::memory_order_relaxed);
+    }
+    //Deepest the queue has been since the last reset, which starts over from the current size
+    size_type high_water(bool reset)
+    {
+        if (reset)
+            return _high_water.exchange(size(), std::memory_order_relaxed);
+        return _high_water.load(std::memory_order_relaxed);
     }
-    //Return false if failed to push due to full queue after the timeout have passed
-    bool push(const T& item, const std::chrono::milliseconds& timeout)
+    //Number of pushes that gave up after their timeout
+    uint64_t push_timeouts() const { return _push_timeouts.load(std::memory_order_relaxed); }
+    //Return false if failed to push due to full queue after the timeout have passed.
+    //waited_ns, if given, gets the time spent waiting for room, 0 when there was no wait
+    bool push(const T& item, const std::chrono::milliseconds& timeout, uint64_t* waited_ns = NULL)
     {
-        auto wait_until = std::chrono::system_clock::now() + timeout;
         {            
             std::unique_lock<std::mutex> ul(_mutex);
-            if (!_item_popped_cond.wait_until(ul, wait_until, [this]() { return this->_q.size() < this->_max_size; }))
+            if (!wait(ul, timeout, _item_popped_cond, [this]() { return this->_q.size() < this->_max_size; }, waited_ns)) {
+                _push_timeouts.fetch_add(1, std::memory_order_relaxed);
                 return false;
+            }
             _q.push(item);
+            _size.store(_q.size(), std::memory_order_relaxed);
+            if (_q.size() > _high_water.load(std::memory_order_relaxed))
+                _high_water.store(_q.size(), std::memory_order_relaxed);
         }        
        _item_pushed_cond.notify_one();
         return true;
     }
-    //Return false if failed to pop due to empty queue after the timeout have passed
-    bool pop(T& item, const std::chrono::milliseconds& timeout)
+    //Return false if failed to pop due to empty queue after the timeout have passed.
+    //waited_ns, if given, gets the time spent waiting for an item, 0 when there was no wait
+    bool pop(T& item, const std::chrono::milliseconds& timeout, uint64_t* waited_ns = NULL)
     {
-        auto wait_until = std::chrono::system_clock::now() + timeout;
         {            
             std::unique_lock<std::mutex> ul(_mutex);
-            if (!_item_pushed_cond.wait_until(ul, wait_until, [this]() { return !this->_q.empty(); }))
+            if (!wait(ul, timeout, _item_pushed_cond, [this]() { return !this->_q.empty(); }, waited_ns))
                 return false;
 
             item = _q.front();
             _q.pop();
+            _size.store(_q.size(), std::memory_order_relaxed);
         }        
         _item_popped_cond.notify_one();
 
         return true;
     }
 private:
+    //wait_until that only reads the clocks, deadline included, when it has to wait
+    template<typename Pred>
+    static bool wait(std::unique_lock<std::mutex>& ul, const std::chrono::milliseconds& timeout,
+                     std::condition_variable& cond, Pred ready, uint64_t* waited_ns)
+    {
+        if (ready()) {
+            if (waited_ns)
+                *waited_ns = 0;
+            return true;
+        }
+        uint64_t start = stat_now_ns();
+        bool ok = cond.wait_until(ul, std::chrono::steady_clock::now() + timeout, ready);
+        if (waited_ns)
+            *waited_ns = stat_now_ns() - start;
+        return ok;
+    }
+
     size_type _max_size;
     std::queue<T> _q;
     std::mutex _mutex;
     std::condition_variable _item_pushed_cond;
     std::condition_variable _item_popped_cond;
+    std::atomic<size_type> _size;
+    std::atomic<size_type> _high_water;     //only changed with the lock held
+    std::atomic<uint64_t> _push_timeouts;
 };
 
 #endif
@@ -1,4 +1,9 @@
 #include "client_data.h"
+#include "output_buffer.h"
+#include <new>
+#include <algorithm>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 
 /*------------------------------------------------------------------------------------------------------------------
 -- SOURCE FILE: client_data.cpp - Hold the code for the client data class used by the scalable servers. 
@@ -9,14 +14,29 @@
 --			  ClientData::~ClientData()
 --			  int ClientData::setFile(char* filename)
 --			  int ClientData::print()
+--			  void ClientData::snapshot(stats_snapshot& snap, bool endInterval)
+--			  const stats_snapshot& ClientData::latest()
+--			  void ClientData::setQueueProbe(void (*probe)(stats_snapshot& snap, bool reset))
+--			  void ClientData::setTcpSampling(int batch)
 --			  int ClientData::addClient(int socket, char* client_addr, int client_port)
 --			  int ClientData::removeClient(int socket)
 --			  int ClientData::empty()
 --			  int ClientData::has(int sock)
 --			  int ClientData::setRtt(int sock)
 --			  int ClientData::recordData(int socket, int number)
+--			  int ClientData::recordSend(bool zerocopy)
+--			  int ClientData::recordAccept(int number)
+--			  int ClientData::recordZerocopyDone(int sends, int copied)
 --			  int ClientData::getNumRequest(int socket)
+--			  uint32_t ClientData::generation(int sock)
+--			  OutputBuffer* ClientData::output(int sock)
+--			  OutputBuffer* ClientData::detachOutput(int sock)
 --			  void ClientData::cleanup(int signum)
+--			  ClientData::ClientData()
+--			  client_data* ClientData::slot(int sock)
+--			  client_data* ClientData::live(int sock)
+--			  client_data* ClientData::shard_slot(int sock)
+--			  void ClientData::sampleTcp(struct tcp_sample& sample)
 --
 -- DATE: 2014/02/21
 --
@@ -27,6 +47,8 @@
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
 -- NOTES: Used by other server type classes, this class handles the list of clients in an organized fashion.
+-- Clients live in a table indexed directly by fd.  Lookups take no lock: add and remove publish through the
+-- slot generation, and per-connection counters are only written by the thread that owns the connection.
 ----------------------------------------------------------------------------------------------------------------------*/
 
 //ClientData* ClientData::m_pInstance = NULL;
@@ -72,9 +94,21 @@ ClientData* ClientData::Instance()
 -- 		  and close each client socket.  
 ----------------------------------------------------------------------------------------------------------------------*/
 ClientData::~ClientData(){
-	fclose(_file);
-	for( std::map<int, client_data>::iterator ii=list_of_clients.begin(); ii!=list_of_clients.end(); ++ii) {
-		close( (*ii).first );
+	if(_file != NULL){
+		fclose(_file);
+	}
+	for(int i = 0; i < TABLE_MAX_SHARDS; ++i){
+		client_data* shard = _shards[i].load(std::memory_order_acquire);
+		if(shard == NULL){
+			continue;
+		}
+		for(int j = 0; j < TABLE_SHARD_SIZE; ++j){
+			if(shard[j].generation.load(std::memory_order_acquire) & 1){
+				close(shard[j].socket);
+			}
+			delete shard[j].out;
+		}
+		free(shard);
 	}
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -115,28 +149,246 @@ int ClientData::setFile(const char* filename){
 --
 -- RETURNS:  Number of clients in the list.
 --
--- NOTES: Print number of clients and the avg RTT of clients in the specified file pointer.
+-- NOTES: Print number of clients and the avg RTT in the specified file pointer, with the rates of accepts,
+-- messages and bytes since the previous print.  Everything but the client count comes from the per-thread
+-- counters, so the connection table is not walked; the RTT average, calcsize (number of RTT samples) and
+-- percentiles cover only the messages since the previous print; RTT is the time between two messages on a
+-- connection.  The client adds the percentiles of its echoes' latency, from when each message was due to be
+-- sent, and of their request time, from when each was sent by the stamp it carries; the two differ by how
+-- late the client sent, behind its schedule or behind the echo before.  While it connects, a line has the connects/s, connect time
+-- percentiles, retries and connections given up on.  A server with a work queue also gets a line
+-- with the queue's high water mark and push/pop waits, and every worker's share of the interval spent busy.
+-- The kernel's view of the connections sampled in the interval gets a line of its own, and so does the CPU
+-- time and context switches (voluntary/involuntary) of every role, with the CPU spent per message echoed.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::print(){
-	unsigned long size =0;
-	double avgRtt =0;
-	double totalRtt=0;
-	int numClients = 0;
-	
-	_mutex.lock();
-	size =  list_of_clients.size() ;
-	
-	for(std::map<int,client_data>::iterator it = list_of_clients.begin(); it!=list_of_clients.end(); ++it){
-		if(it->second.rtt !=0){
-			totalRtt += it->second.rtt;
-			++numClients;
+	stats_snapshot now;
+	snapshot(now, true);
+
+	double elapsed = (now.when.tv_sec - _last.when.tv_sec) + (now.when.tv_nsec - _last.when.tv_nsec) / 1e9;
+	if(elapsed <= 0){
+		elapsed = 1;
+	}
+	HistogramSnapshot interval = now.rtt;
+	interval.subtract(_last.rtt);
+	uint64_t samples = interval.total();
+	double avgRtt = samples > 0 ? (double)(now.rtt_sum - _last.rtt_sum) / samples : 0;
+
+	fprintf(_file,"clients: %lu \tRTT: %lf \tcalcsize:%lu \taccepts/s: %.0lf \tmsgs/s: %.0lf \tbytes/s: %.0lf\n",
+		now.clients, avgRtt, (unsigned long) samples, (now.accepts - _last.accepts) / elapsed,
+		(now.messages - _last.messages) / elapsed, (now.bytes - _last.bytes) / elapsed);
+	fprintf(_file,"RTT(us) p50: %lu \tp90: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu \tcount: %lu\n",
+		(unsigned long) interval.percentile(50), (unsigned long) interval.percentile(90),
+		(unsigned long) interval.percentile(99), (unsigned long) interval.percentile(99.9),
+		(unsigned long) interval.max(), (unsigned long) samples);
+	HistogramSnapshot latency = now.latency;
+	latency.subtract(_last.latency);
+	if(latency.total() > 0){
+		fprintf(_file,"latency(us) p50: %lu \tp90: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu \tcount: %lu\n",
+			(unsigned long) latency.percentile(50), (unsigned long) latency.percentile(90),
+			(unsigned long) latency.percentile(99), (unsigned long) latency.percentile(99.9),
+			(unsigned long) latency.max(), (unsigned long) latency.total());
+	}
+	HistogramSnapshot request = now.request;
+	request.subtract(_last.request);
+	if(request.total() > 0){
+		fprintf(_file,"request(us) p50: %lu \tp90: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu \tcount: %lu\n",
+			(unsigned long) request.percentile(50), (unsigned long) request.percentile(90),
+			(unsigned long) request.percentile(99), (unsigned long) request.percentile(99.9),
+			(unsigned long) request.max(), (unsigned long) request.total());
+	}
+	HistogramSnapshot connect = now.connect;
+	connect.subtract(_last.connect);
+	if(connect.total() > 0 || now.connect_retries != _last.connect_retries || now.connect_failures != _last.connect_failures){
+		fprintf(_file,"connects/s: %.0lf 	connect(us) p50: %lu 	p99: %lu 	max: %lu 	retries: %lu 	failed: %lu\n",
+			(now.connects - _last.connects) / elapsed, (unsigned long) connect.percentile(50),
+			(unsigned long) connect.percentile(99), (unsigned long) connect.max(),
+			(unsigned long)(now.connect_retries - _last.connect_retries),
+			(unsigned long)(now.connect_failures - _last.connect_failures));
+	}
+	if(now.queue_depth >= 0){
+		HistogramSnapshot pushWait = now.push_wait, popWait = now.pop_wait;
+		pushWait.subtract(_last.push_wait);
+		popWait.subtract(_last.pop_wait);
+		fprintf(_file,"queue depth: %ld 	high water: %ld 	push timeouts: %lu 	push wait(ns) p99: %lu 	max: %lu"
+			" 	pop wait(ns) p50: %lu 	p99: %lu\n", now.queue_depth, now.queue_high_water,
+			(unsigned long) now.push_timeouts, (unsigned long) pushWait.percentile(99), (unsigned long) pushWait.max(),
+			(unsigned long) popWait.percentile(50), (unsigned long) popWait.percentile(99));
+	}
+	// threads that time their work are workers, reactors or rings; every thread's CPU is added up by role
+	int workers = 0, roles = 0;
+	double busySum = 0;
+	struct role_usage usage[STATS_MAX_ROLES];
+	uint64_t cpuSum = 0;
+	int n = ThreadStats::count();
+	for(int i = 0; i < n; i++){
+		thread_stats* t = ThreadStats::at(i);
+		uint64_t busy = t->busy_ns.load(std::memory_order_relaxed);
+		const char* role = t->role.load(std::memory_order_relaxed);
+		if(role != NULL && t->timed.load(std::memory_order_relaxed)){
+			double pct = (busy - _lastBusy[i]) / (elapsed * 1e9) * 100;
+			fprintf(_file, workers == 0 ? "worker busy%%: %.1lf" : " %.1lf", pct);
+			busySum += pct;
+			workers++;
+		}
+		_lastBusy[i] = busy;
+
+		uint64_t cpu = t->cpu_ns.load(std::memory_order_relaxed);
+		uint64_t voluntary = t->csw_voluntary.load(std::memory_order_relaxed);
+		uint64_t involuntary = t->csw_involuntary.load(std::memory_order_relaxed);
+		bool running = t->in_use.load(std::memory_order_relaxed);
+		if(role == NULL){
+			role = "other";
+		}
+		int r = 0;
+		while(r < roles && strcmp(usage[r].role, role) != 0){
+			r++;
 		}
+		if(r == roles && roles < STATS_MAX_ROLES && (running || cpu != _lastCpu[i])){
+			usage[roles++] = role_usage{role, 0, 0, 0, 0};
+		}
+		if(r < roles){
+			usage[r].threads += running;
+			usage[r].cpu_ns += cpu - _lastCpu[i];
+			usage[r].voluntary += voluntary - _lastVoluntary[i];
+			usage[r].involuntary += involuntary - _lastInvoluntary[i];
+		}
+		cpuSum += cpu - _lastCpu[i];
+		_lastCpu[i] = cpu;
+		_lastVoluntary[i] = voluntary;
+		_lastInvoluntary[i] = involuntary;
+	}
+	if(workers > 0){
+		fprintf(_file," 	mean busy%%: %.1lf 	idle%%: %.1lf\n", busySum / workers, 100 - busySum / workers);
+	}
+	if(roles > 0){
+		for(int r = 0; r < roles; r++){
+			fprintf(_file, r == 0 ? "cpu(ms) %s x%d: %.1lf csw: %lu/%lu" : " \t%s x%d: %.1lf csw: %lu/%lu", usage[r].role,
+				usage[r].threads, usage[r].cpu_ns / 1e6, (unsigned long) usage[r].voluntary,
+				(unsigned long) usage[r].involuntary);
+		}
+		uint64_t messages = now.messages - _last.messages;
+		fprintf(_file, " \tcpu(us)/msg: %.2lf\n", messages > 0 ? cpuSum / 1e3 / messages : 0.0);
+	}
+	if(now.tcp.sampled > 0){
+		fprintf(_file,"tcp_info sampled: %ld \trtt(us) avg: %.0lf \tp50: %lu \tp99: %lu \tmax: %lu \trttvar avg: %.0lf"
+			" \tcwnd avg: %.1lf \tunacked(bytes) avg: %.0lf \tmax: %lu \tretrans: %lu \trecovering: %ld\n",
+			now.tcp.sampled, (double) now.tcp.rtt_sum / now.tcp.sampled, (unsigned long) std::min(now.tcp.rtt.percentile(50), now.tcp.rtt_max),
+			(unsigned long) std::min(now.tcp.rtt.percentile(99), now.tcp.rtt_max), (unsigned long) now.tcp.rtt_max,
+			(double) now.tcp.rttvar_sum / now.tcp.sampled, (double) now.tcp.cwnd_sum / now.tcp.sampled,
+			(double) now.tcp.unacked_sum / now.tcp.sampled, (unsigned long) now.tcp.unacked_max,
+			(unsigned long) now.tcp.retrans, now.tcp.recovering);
+	}
+	if(now.sends_copied + now.sends_zerocopy > 0){
+		fprintf(_file,"sends copied: %lu \tzerocopy: %lu \tcompleted: %lu \tkernel copied: %lu\n",
+			(unsigned long) now.sends_copied, (unsigned long) now.sends_zerocopy,
+			(unsigned long) now.zerocopy_done, (unsigned long) now.zerocopy_copied);
 	}
-	_mutex.unlock();
-	avgRtt = totalRtt / numClients;
-	fprintf(_file,"clients: %lu \tRTT: %lf \tcalcsize:%d\n", size, avgRtt,numClients);
 	fflush(_file);
-	return list_of_clients.size();
+	_last = now;
+	return now.clients;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: snapshot
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ClientData::snapshot(stats_snapshot& snap, bool endInterval)
+--                            stats_snapshot& snap - filled with the current totals
+--                            bool endInterval     - the snapshot closes a stats interval: the queue high water
+--                                                   mark starts over and the next batch of connections has
+--                                                   its TCP_INFO sampled
+--
+-- RETURNS:  void
+--
+-- NOTES: Merges every thread's counters and histograms.  Takes no lock the echo path uses.
+----------------------------------------------------------------------------------------------------------------------*/
+void ClientData::snapshot(stats_snapshot& snap, bool endInterval){
+	ThreadStats::merge(snap);
+	snap.clients = _count.load(std::memory_order_relaxed);
+	void (*probe)(stats_snapshot&, bool) = _queueProbe.load(std::memory_order_acquire);
+	if(probe != NULL){
+		probe(snap, endInterval);
+	} else {
+		snap.queue_depth = snap.queue_high_water = -1;
+		snap.push_timeouts = 0;
+	}
+	snap.tcp = tcp_sample();
+	if(endInterval && _tcpBatch > 0){
+		sampleTcp(snap.tcp);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &snap.when);
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: latest
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: const stats_snapshot& ClientData::latest()
+--
+-- RETURNS:  the snapshot taken by the last print()
+--
+-- NOTES: Only for the stats thread, which is the one that calls print().
+----------------------------------------------------------------------------------------------------------------------*/
+const stats_snapshot& ClientData::latest(){
+	return _last;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setQueueProbe
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ClientData::setQueueProbe(void (*probe)(stats_snapshot& snap, bool reset))
+--                            void (*probe)(stats_snapshot& snap, bool reset) - fills in the queue depth, high
+--                                                   water mark and push timeouts, and restarts the high water
+--                                                   mark when reset is true
+--
+-- RETURNS:  void
+--
+-- NOTES: Called by a server with a work queue.  The probe runs on the stats thread at every snapshot, so it
+-- must not take a lock the workers use.
+----------------------------------------------------------------------------------------------------------------------*/
+void ClientData::setQueueProbe(void (*probe)(stats_snapshot& snap, bool reset)){
+	_queueProbe.store(probe, std::memory_order_release);
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setTcpSampling
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ClientData::setTcpSampling(int batch)
+--                            int batch - connections whose TCP_INFO is read per stats interval, 0 for none
+--
+-- RETURNS:  void
+--
+-- NOTES: Must be called before the stats thread starts.
+----------------------------------------------------------------------------------------------------------------------*/
+void ClientData::setTcpSampling(int batch){
+	_tcpBatch = batch > 0 ? batch : 0;
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: addClient
@@ -154,27 +406,40 @@ int ClientData::print(){
 --					char* client_addr - client address struct
 --					int client_port   - client port
 --
--- RETURNS:  0 on sucess
+-- RETURNS:  0 on sucess, -1 if the socket is outside the table
 --
--- NOTES: Adds a client to the map container list.
+-- NOTES: Adds a client to the connection table.  The slot is filled in before the new (odd) generation is
+-- published, so a concurrent lookup sees either no client or a complete one.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::addClient(int socket, char* client_addr, int client_port){
-	struct client_data tempData;
-	tempData.socket=socket;
-	memcpy(tempData.client_addr,client_addr, strlen( client_addr));
-	tempData.client_port = client_port;
-	
-	tempData.num_request=0;
-	tempData.rtt = 0;
-	tempData.amount_data=0;
-	tempData.lasttime = 0;
-	tempData.last_time.tv_sec = 0;
-	tempData.last_time.tv_usec = 0;
+	client_data* data = shard_slot(socket);
+	if(data == NULL){
+		return -1;
+	}
+	uint32_t gen = data->generation.load(std::memory_order_relaxed);
+	if(gen & 1){
+		// the fd was closed without being removed, retire the old client
+		--_count;
+		++gen;
+	}
+	data->socket=socket;
+	strncpy(data->client_addr, client_addr, sizeof(data->client_addr) - 1);
+	data->client_addr[sizeof(data->client_addr) - 1] = '\0';
+	data->client_port = client_port;
 	
+	data->num_request.store(0, std::memory_order_relaxed);
+	data->rtt.store(0, std::memory_order_relaxed);
+	data->amount_data.store(0, std::memory_order_relaxed);
+	data->lasttime.store(0, std::memory_order_relaxed);
+	if(data->out != NULL){
+		data->out->clear();
+	}
 	
-	_mutex.lock();
-	list_of_clients.insert(std::pair<int, client_data>(socket, tempData));
-	_mutex.unlock();
+	data->generation.store(gen + 1, std::memory_order_release);
+	++_count;
+
+	int maxfd = _maxfd.load(std::memory_order_relaxed);
+	while(socket > maxfd && !_maxfd.compare_exchange_weak(maxfd, socket));
 	return 0;
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -192,18 +457,25 @@ int ClientData::addClient(int socket, char* client_addr, int client_port){
 --
 -- RETURNS:  0 on success
 --
--- NOTES: Erases the client data from the list based on the client socket passed in.
+-- NOTES: Erases the client data from the table based on the client socket passed in.  The socket must still be
+-- open, so its slot cannot go to a new client meanwhile.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::removeClient(int socket){
-	_mutex.lock();
-	std::map<int,client_data>::iterator data = list_of_clients.find(socket);
-	_mutex.unlock();
-	if(data != list_of_clients.end()){
-		std::cout<<"Disconnected: socket:"<<socket<<"\thostname:"<< data->second.client_addr<<"\t#requests: "<< data->second.num_request<< "\t#data: "<< data->second.amount_data << std::endl;
-	}
-	_mutex.lock();
-	list_of_clients.erase(socket);
-	_mutex.unlock();
+	client_data* data = live(socket);
+	if(data == NULL){
+		return 0;
+	}
+	uint32_t gen = data->generation.load(std::memory_order_relaxed);
+	// only the first of two racing removes retires the slot, and logs the disconnect.  the fd is still open,
+	// so the slot cannot be handed to a new client while it is read here
+	if((gen & 1) && data->generation.compare_exchange_strong(gen, gen + 1, std::memory_order_acq_rel)){
+		LOG_INFO("Disconnected: socket:%d\thostname:%s\t#requests: %d\t#data: %ld", socket, data->client_addr,
+			data->num_request.load(std::memory_order_relaxed), data->amount_data.load(std::memory_order_relaxed));
+		--_count;
+		if(data->out != NULL){
+			data->out->clear();
+		}
+	}
 	return 0;
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -224,12 +496,7 @@ int ClientData::removeClient(int socket){
 -- NOTES: Returns true or false if the number of clients in the list are empty.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::empty(){
-	int empty;
-	_mutex.lock();
-	empty = list_of_clients.empty();
-	_mutex.unlock();
-	return empty;
-
+	return _count.load(std::memory_order_acquire) == 0;
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: has
@@ -245,22 +512,19 @@ int ClientData::empty(){
 -- INTERFACE: int ClientData::has(int sock)
 --			  	  int sock - client socket passed in
 --
--- RETURNS:  true if the map contains the client data whose socket is matched to.
+-- RETURNS:  true if the table contains the client data whose socket is matched to.
 --
--- NOTES: Returns true or false if the map container has the client data with the matching client socket.
+-- NOTES: Returns true or false if the connection table has a live client on the matching client socket.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::has(int sock){
-	_mutex.lock();
-	int rtn = list_of_clients.count(sock);
-	_mutex.unlock();
-	return rtn;
+	return live(sock) != NULL;
 }
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: setRtt
 --
 -- DATE: 2014/02/21
 --
--- REVISIONS: (Date and Description)
+-- REVISIONS: 2026/10/18 - timed with ClockSource instead of gettimeofday, which NTP can step
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -271,26 +535,27 @@ int ClientData::has(int sock){
 --
 -- RETURNS:  calculated ReturnTripTime in milliseconds.  if it has no previous time value, returns -1
 --
--- NOTES: calculates the RTT if previous timeval last_time exists.  Sets last_time to current time
+-- NOTES: calculates the RTT if a previous time last_time exists.  Sets last_time to current time
+-- The RTT and message also go into the calling thread's stats block.
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::setRtt(int socket){
 	int rtt = -1;
-	struct timeval currTime;
-	gettimeofday(&currTime,NULL);
-	long thistime = currTime.tv_sec * 1000000 + currTime.tv_usec;
+	long thistime = ClockSource::now_us();
 
-	_mutex.lock();
-	std::map<int,client_data>::iterator data = list_of_clients.find(socket);
-	_mutex.unlock();
-	if(data != list_of_clients.end()){
-	
-		if(data->second.lasttime > 0){
+	client_data* data = live(socket);
+	if(data != NULL){
+		long lasttime = data->lasttime.load(std::memory_order_relaxed);
+		if(lasttime > 0){
 			
-			rtt = thistime- data->second.lasttime;
-			data->second.rtt = rtt;
+			rtt = thistime- lasttime;
+			data->rtt.store(rtt, std::memory_order_relaxed);
+			thread_stats* stats = ThreadStats::local();
+			stats->rtt.record(rtt);
+			stat_add(stats->rtt_sum, rtt);
 		}
-		data->second.lasttime = thistime;
-		++ data->second.num_request;
+		data->lasttime.store(thistime, std::memory_order_relaxed);
+		data->num_request.store(data->num_request.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		stat_add(ThreadStats::local()->messages, 1);
 	}
 	
 	return rtt;
@@ -316,15 +581,85 @@ int ClientData::setRtt(int socket){
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::recordData(int socket, int number){
 	long total = 0;
-	_mutex.lock();
-	std::map<int,client_data>::iterator data = list_of_clients.find(socket);
-	_mutex.unlock();
-	if(data != list_of_clients.end()){
-		data->second.amount_data += number;
-		total = data->second.amount_data;
+	client_data* data = live(socket);
+	if(data != NULL){
+		total = data->amount_data.load(std::memory_order_relaxed) + number;
+		data->amount_data.store(total, std::memory_order_relaxed);
+		stat_add(ThreadStats::local()->bytes, number);
 	}
 	return total;
 }
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recordSend
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ClientData::recordSend(bool zerocopy)
+--                            bool zerocopy - the echo went out with MSG_ZEROCOPY
+--
+-- RETURNS:  0
+--
+-- NOTES: Counts copied and zero-copy sends so the zero-copy threshold can be tuned.
+----------------------------------------------------------------------------------------------------------------------*/
+int ClientData::recordSend(bool zerocopy){
+	thread_stats* stats = ThreadStats::local();
+	stat_add(zerocopy ? stats->sends_zerocopy : stats->sends_copied, 1);
+	return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recordAccept
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ClientData::recordAccept(int number)
+--                            int number - connections accepted
+--
+-- RETURNS:  0
+--
+-- NOTES: Counts accepted connections for the accepts/s figure.  Batching accept paths record a whole batch at
+-- once.
+----------------------------------------------------------------------------------------------------------------------*/
+int ClientData::recordAccept(int number){
+	stat_add(ThreadStats::local()->accepts, number);
+	return 0;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recordZerocopyDone
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ClientData::recordZerocopyDone(int sends, int copied)
+--                            int sends - zero-copy sends the kernel reported complete
+--                            int copied - how many of them the kernel copied anyway
+--
+-- RETURNS:  0
+--
+-- NOTES: A high copied count (always the case over loopback) means the threshold is too low to pay off.
+----------------------------------------------------------------------------------------------------------------------*/
+int ClientData::recordZerocopyDone(int sends, int copied){
+	thread_stats* stats = ThreadStats::local();
+	stat_add(stats->zerocopy_done, sends);
+	stat_add(stats->zerocopy_copied, copied);
+	return 0;
+}
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: getNumRequest
 --
@@ -344,17 +679,282 @@ int ClientData::recordData(int socket, int number){
 -- NOTES: getter function for number of requests received
 ----------------------------------------------------------------------------------------------------------------------*/
 int ClientData::getNumRequest(int socket){
-	_mutex.lock();
-	std::map<int,client_data>::iterator data = list_of_clients.find(socket);
-	_mutex.unlock();
-	if(data != list_of_clients.end()){
-		return data->second.num_request;
+	client_data* data = live(socket);
+	if(data != NULL){
+		return data->num_request.load(std::memory_order_relaxed);
 	}
 	return 0;
 }
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: generation
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint32_t ClientData::generation(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  current generation of the socket's slot (odd while a client is live), 0 if it was never used
+--
+-- NOTES: Lets a server tag queued work with the connection it was meant for, and drop it once that
+-- connection has been removed even if the fd has already been reused.
+----------------------------------------------------------------------------------------------------------------------*/
+uint32_t ClientData::generation(int sock){
+	client_data* data = slot(sock);
+	if(data == NULL){
+		return 0;
+	}
+	return data->generation.load(std::memory_order_acquire);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: output
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: OutputBuffer* ClientData::output(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  the output buffer of the live client on the socket, NULL if there is none
+--
+-- NOTES: Creates the buffer the first time the slot needs one.  Only the thread that owns the connection may
+-- call this or use the buffer.
+----------------------------------------------------------------------------------------------------------------------*/
+OutputBuffer* ClientData::output(int sock){
+	client_data* data = live(sock);
+	if(data == NULL){
+		return NULL;
+	}
+	if(data->out == NULL){
+		data->out = new OutputBuffer();
+	}
+	return data->out;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: detachOutput
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: OutputBuffer* ClientData::detachOutput(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  the output buffer of the live client on the socket, NULL if it has none
+--
+-- NOTES: Hands the buffer over to the caller, who frees it; the slot makes a new one when it next needs one.
+-- For a connection that is closing with buffers still pinned by MSG_ZEROCOPY sends.
+----------------------------------------------------------------------------------------------------------------------*/
+OutputBuffer* ClientData::detachOutput(int sock){
+	client_data* data = live(sock);
+	if(data == NULL){
+		return NULL;
+	}
+	OutputBuffer* out = data->out;
+	data->out = NULL;
+	return out;
+}
 
 
 void ClientData::cleanup(int signum){
 
 	exit(signum);
 }
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ClientData (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: ClientData::ClientData()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Starts with an empty table; shards are allocated as fds in their range are first used.
+----------------------------------------------------------------------------------------------------------------------*/
+ClientData::ClientData() : _file(NULL), _maxfd(-1), _count(0), _queueProbe(NULL), _tcpBatch(TCP_SAMPLE_BATCH),
+	_tcpCursor(0){
+	memset(_lastBusy, 0, sizeof(_lastBusy));
+	memset(_lastCpu, 0, sizeof(_lastCpu));
+	memset(_lastVoluntary, 0, sizeof(_lastVoluntary));
+	memset(_lastInvoluntary, 0, sizeof(_lastInvoluntary));
+	snapshot(_last);
+	for(int i = 0; i < TABLE_MAX_SHARDS; ++i){
+		_shards[i].store(NULL, std::memory_order_relaxed);
+	}
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: slot
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: client_data* ClientData::slot(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  the table slot for the socket, NULL if its shard was never allocated
+--
+-- NOTES: Lock-free lookup: one shard pointer load and an index.
+----------------------------------------------------------------------------------------------------------------------*/
+client_data* ClientData::slot(int sock){
+	if(sock < 0 || sock >= TABLE_MAX_FDS){
+		return NULL;
+	}
+	client_data* shard = _shards[sock >> TABLE_SHARD_BITS].load(std::memory_order_acquire);
+	if(shard == NULL){
+		return NULL;
+	}
+	return &shard[sock & (TABLE_SHARD_SIZE - 1)];
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: live
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: client_data* ClientData::live(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  the table slot for the socket if it holds a live client, NULL otherwise
+--
+-- NOTES: Same as slot() but also checks the generation.
+----------------------------------------------------------------------------------------------------------------------*/
+client_data* ClientData::live(int sock){
+	client_data* data = slot(sock);
+	if(data == NULL || !(data->generation.load(std::memory_order_acquire) & 1)){
+		return NULL;
+	}
+	return data;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: shard_slot
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: client_data* ClientData::shard_slot(int sock)
+--                            int sock - client socket
+--
+-- RETURNS:  the table slot for the socket, NULL if the socket is outside the table
+--
+-- NOTES: Like slot() but allocates the socket's shard first if needed.  Two threads racing to allocate the
+-- same shard both build one and the loser frees its copy, so lookups never wait on an allocation.
+----------------------------------------------------------------------------------------------------------------------*/
+client_data* ClientData::shard_slot(int sock){
+	if(sock < 0 || sock >= TABLE_MAX_FDS){
+		return NULL;
+	}
+	std::atomic<client_data*>& entry = _shards[sock >> TABLE_SHARD_BITS];
+	client_data* shard = entry.load(std::memory_order_acquire);
+	if(shard == NULL){
+		void* mem = NULL;
+		if(posix_memalign(&mem, CACHE_LINE, TABLE_SHARD_SIZE * sizeof(client_data)) != 0){
+			return NULL;
+		}
+		client_data* fresh = static_cast<client_data*>(mem);
+		for(int i = 0; i < TABLE_SHARD_SIZE; ++i){
+			new (&fresh[i]) client_data();
+			fresh[i].generation.store(0, std::memory_order_relaxed);
+			fresh[i].out = NULL;
+		}
+		if(entry.compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)){
+			shard = fresh;
+		} else {
+			free(fresh);
+		}
+	}
+	return &shard[sock & (TABLE_SHARD_SIZE - 1)];
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sampleTcp
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ClientData::sampleTcp(struct tcp_sample& sample)
+--                            struct tcp_sample& sample - receives the figures of the connections read
+--
+-- RETURNS:  void
+--
+-- NOTES: Reads TCP_INFO of the next _tcpBatch live connections after the one the last call stopped at, so
+-- every connection is visited in turn however many there are, and each interval costs at most _tcpBatch
+-- getsockopt and SIOCOUTQ calls.  The owning thread may close the fd meanwhile; a read whose slot changed generation is
+-- thrown away, and one that hits a reused fd that is not a socket just fails.
+----------------------------------------------------------------------------------------------------------------------*/
+void ClientData::sampleTcp(struct tcp_sample& sample){
+	struct tcp_info info;
+	socklen_t len;
+	int maxfd = _maxfd.load(std::memory_order_relaxed);
+	if(maxfd < 0){
+		return;
+	}
+	for(int seen = 0; seen <= maxfd && sample.sampled < _tcpBatch; seen++){
+		int sock = _tcpCursor;
+		_tcpCursor = _tcpCursor >= maxfd ? 0 : _tcpCursor + 1;
+		uint32_t gen = generation(sock);
+		if(!(gen & 1)){
+			continue;
+		}
+		len = sizeof(info);
+		if(getsockopt(sock, IPPROTO_TCP, TCP_INFO, &info, &len) != 0 || len < sizeof(info)
+			|| generation(sock) != gen){
+			continue;
+		}
+		// tcpi_unacked is in segments; the send queue has the bytes
+		int queued = 0;
+		uint64_t unacked = ioctl(sock, SIOCOUTQ, &queued) == 0 && queued > 0 ? queued : 0;
+		sample.sampled++;
+		sample.rtt_sum += info.tcpi_rtt;
+		sample.rtt_max = std::max(sample.rtt_max, (uint64_t) info.tcpi_rtt);
+		sample.rtt.add(Histogram::index(info.tcpi_rtt), 1);
+		sample.rttvar_sum += info.tcpi_rttvar;
+		sample.cwnd_sum += info.tcpi_snd_cwnd;
+		sample.unacked_sum += unacked;
+		sample.unacked_max = std::max(sample.unacked_max, unacked);
+		sample.retrans += info.tcpi_total_retrans;
+		if(info.tcpi_retransmits > 0 || info.tcpi_ca_state != TCP_CA_Open){
+			sample.recovering++;
+		}
+	}
+}
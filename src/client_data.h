@@ -10,22 +10,64 @@
 #include <strings.h>
 #include <unistd.h>
 #include <string.h>
-#include <map>
-#include <mutex>
+#include <atomic>
+#include <stdint.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
 #include <sys/time.h>
+#include <time.h>
+
+#include "histogram.h"
+#include "thread_stats.h"
+#include "logger.h"
 
 #define BUFLEN 255
-struct client_data {
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
 
-	char client_addr[BUFLEN];
-	int client_port;
+// the connection table is indexed by fd, in lazily allocated shards of 4096 slots
+#define TABLE_SHARD_BITS 12
+#define TABLE_SHARD_SIZE (1 << TABLE_SHARD_BITS)
+#define TABLE_MAX_SHARDS 1024
+#define TABLE_MAX_FDS (TABLE_MAX_SHARDS * TABLE_SHARD_SIZE)
+
+#define TCP_SAMPLE_BATCH 256	// connections whose TCP_INFO is read per stats interval
+#define STATS_MAX_ROLES 16		// thread roles the CPU line has room for
+
+/**
+CPU time and context switches of the threads in one role over a stats interval.
+*/
+struct role_usage {
+	const char* role;
+	int threads;			// running now
+	uint64_t cpu_ns;
+	uint64_t voluntary, involuntary;
+};
+
+class OutputBuffer;
+
+/**
+one slot of the connection table, a cache line each.  generation is odd while
+the slot holds a live client and is bumped on every add and remove, so a
+reader can tell a reused fd from the connection it was looking for.  the
+counters are only written by the thread that owns the connection, so they are
+plain relaxed loads/stores with no read-modify-write.  the output buffer is
+created on first use and kept with the slot for the next client on the fd.
+*/
+struct alignas(CACHE_LINE) client_data {
+	std::atomic<uint32_t> generation;
 	int socket;
-	struct timeval last_time;
-	long lasttime;
-	int rtt;
-	long amount_data;
-	int num_request;
+	int client_port;
+	std::atomic<int> rtt;
+	char client_addr[INET_ADDRSTRLEN];
+	std::atomic<long> lasttime;
+	std::atomic<long> amount_data;
+	std::atomic<int> num_request;
+	OutputBuffer* out;
 };
+static_assert(sizeof(client_data) == CACHE_LINE, "client_data must fill exactly one cache line");
 
 
 
@@ -35,6 +77,10 @@ public:
 	static ClientData* Instance();
 	~ClientData();
 	int print();
+	void snapshot(stats_snapshot& snap, bool endInterval = false);
+	const stats_snapshot& latest();
+	void setQueueProbe(void (*probe)(stats_snapshot& snap, bool reset));
+	void setTcpSampling(int batch);
 	int addClient(int socket, char* client_addr, int client_port);
 	int removeClient(int socket);
 	int setFile(const char* filename);
@@ -42,13 +88,37 @@ public:
 	int has(int sock);
 	int setRtt(int sock);
 	int recordData(int socket, int number);
+	int recordSend(bool zerocopy);
+	int recordAccept(int number);
+	int recordZerocopyDone(int sends, int copied);
 	int getNumRequest(int socket);
+	uint32_t generation(int sock);
+	OutputBuffer* output(int sock);
+	OutputBuffer* detachOutput(int sock);
 	void cleanup(int signum);
 private:
-	FILE* _file;
-	std::map<int, client_data> list_of_clients;
+	ClientData();
+	client_data* slot(int sock);
+	client_data* live(int sock);
+	client_data* shard_slot(int sock);
+	void sampleTcp(struct tcp_sample& sample);
 
-	std::mutex _mutex;
+	FILE* _file;
+	std::atomic<client_data*> _shards[TABLE_MAX_SHARDS];
+	std::atomic<int> _maxfd;
+	std::atomic<long> _count;
+	// totals at the previous print, to report each interval on its own
+	stats_snapshot _last;
+	// fills in the queue figures of a snapshot without a lock, NULL if the server has no work queue
+	std::atomic<void (*)(stats_snapshot&, bool)> _queueProbe;
+	// each thread's busy time, CPU time and context switches at the previous print
+	uint64_t _lastBusy[MAX_STAT_THREADS];
+	uint64_t _lastCpu[MAX_STAT_THREADS];
+	uint64_t _lastVoluntary[MAX_STAT_THREADS];
+	uint64_t _lastInvoluntary[MAX_STAT_THREADS];
+	// connections sampled per interval, and the fd the next sample starts from; stats thread only
+	int _tcpBatch;
+	int _tcpCursor;
 
 };
 
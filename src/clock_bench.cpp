@@ -0,0 +1,218 @@
+#include "clock_source.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <time.h>
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: clock_bench.cpp - Microbenchmark of the clocks a timestamp can be taken from.
+--
+-- PROGRAM: clock_bench
+--
+-- FUNCTIONS: static uint64_t read_clock(clockid_t id)
+--			  static uint64_t read_monotonic()
+--			  static uint64_t read_coarse()
+--			  static uint64_t read_raw()
+--			  static uint64_t read_realtime()
+--			  static uint64_t read_gettimeofday()
+--			  static uint64_t read_source()
+--			  static uint64_t read_rdtsc()
+--			  double run_bench(long reads, uint64_t& step)
+--			  int main(int argc, char **argv)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Reads every clock back to back and prints the cost of a read and the smallest step seen between two
+-- reads, next to the resolution the kernel claims.  Shows what ClockSource picked on this host and what the
+-- fallbacks would cost.
+--	./clock_bench [reads]
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define CLOCK_BENCH_READS 10000000
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_clock
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static uint64_t read_clock(clockid_t id)
+--				clockid_t id - clock to read
+--
+-- RETURNS:  the clock in nanoseconds
+--
+-- NOTES: The read_ functions below wrap one clock each, so the benchmark can take them as template arguments
+-- and inline them.
+----------------------------------------------------------------------------------------------------------------------*/
+static inline uint64_t read_clock(clockid_t id)
+{
+	struct timespec ts;
+	clock_gettime(id, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t read_monotonic() { return read_clock(CLOCK_MONOTONIC); }
+static uint64_t read_coarse() { return read_clock(CLOCK_MONOTONIC_COARSE); }
+static uint64_t read_raw() { return read_clock(CLOCK_MONOTONIC_RAW); }
+static uint64_t read_realtime() { return read_clock(CLOCK_REALTIME); }
+static uint64_t read_source() { return ClockSource::now_ns(); }
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_gettimeofday
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static uint64_t read_gettimeofday()
+--
+-- RETURNS:  wall clock time in nanoseconds
+--
+-- NOTES: What setRtt used to call on every message.
+----------------------------------------------------------------------------------------------------------------------*/
+static uint64_t read_gettimeofday()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (uint64_t) tv.tv_sec * 1000000000ULL + tv.tv_usec * 1000ULL;
+}
+
+#ifdef CLOCK_HAVE_TSC
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_rdtsc
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static uint64_t read_rdtsc()
+--
+-- RETURNS:  the raw TSC, in ticks rather than nanoseconds
+--
+-- NOTES: The floor under the tsc source: the difference is the scaling multiply.
+----------------------------------------------------------------------------------------------------------------------*/
+static uint64_t read_rdtsc()
+{
+	return __rdtsc();
+}
+#endif
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: run_bench
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: double run_bench(long reads, uint64_t& step)
+--				long reads     - number of back to back reads
+--				uint64_t& step - receives the smallest non-zero difference between two reads, 0 if none
+--
+-- RETURNS:  nanoseconds per read
+--
+-- NOTES: Each read depends on nothing but is compared with the one before, so the compiler can't drop it.
+----------------------------------------------------------------------------------------------------------------------*/
+template<uint64_t (*READ)()>
+double run_bench(long reads, uint64_t& step)
+{
+	uint64_t last = READ(), smallest = ~0ULL;
+	uint64_t start = read_clock(CLOCK_MONOTONIC);
+	for(long i = 0; i < reads; i++){
+		uint64_t t = READ();
+		if(t != last && t - last < smallest){
+			smallest = t - last;
+		}
+		last = t;
+	}
+	uint64_t end = read_clock(CLOCK_MONOTONIC);
+	step = smallest != ~0ULL ? smallest : 0;
+	return (double)(end - start) / reads;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: main (clock_bench)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int main(int argc, char **argv)
+--		       int argc - number of cmd-line arguments
+--		       char **argv - double pointer to array of arguments
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Ends with how far the tsc source has drifted from CLOCK_MONOTONIC since the calibration.
+----------------------------------------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	long reads = argc > 1 ? atol(argv[1]) : CLOCK_BENCH_READS;
+	if(reads <= 0){
+		fprintf(stderr, "Usage: %s [reads]\n", argv[0]);
+		return 1;
+	}
+	struct timespec res;
+	uint64_t step;
+	double ns;
+
+	printf("ClockSource: %s", ClockSource::name());
+	if(ClockSource::source() == CLOCK_SOURCE_TSC){
+		printf(" at %.3lf GHz", ClockSource::tsc_ghz());
+	}
+	printf("\n%-26s %10s %12s %12s\n", "clock", "ns/read", "min step ns", "res ns");
+
+#define BENCH(label, fn, id) \
+	ns = run_bench<fn>(reads, step); \
+	if(id < 0 || clock_getres(id, &res) != 0){ \
+		res.tv_sec = 0; \
+		res.tv_nsec = 0; \
+	} \
+	printf("%-26s %10.2lf %12lu %12ld\n", label, ns, (unsigned long) step, (long)(res.tv_sec * 1000000000L + res.tv_nsec));
+
+	BENCH("ClockSource::now_ns", read_source, -1)
+#ifdef CLOCK_HAVE_TSC
+	BENCH("rdtsc (ticks)", read_rdtsc, -1)
+#endif
+	BENCH("CLOCK_MONOTONIC", read_monotonic, CLOCK_MONOTONIC)
+	BENCH("CLOCK_MONOTONIC_COARSE", read_coarse, CLOCK_MONOTONIC_COARSE)
+	BENCH("CLOCK_MONOTONIC_RAW", read_raw, CLOCK_MONOTONIC_RAW)
+	BENCH("CLOCK_REALTIME", read_realtime, CLOCK_REALTIME)
+	BENCH("gettimeofday", read_gettimeofday, CLOCK_REALTIME)
+#undef BENCH
+
+	if(ClockSource::source() == CLOCK_SOURCE_TSC){
+		uint64_t before = read_monotonic();
+		uint64_t tsc = ClockSource::now_ns();
+		uint64_t after = read_monotonic();
+		printf("tsc - CLOCK_MONOTONIC: %.0lf ns\n", (double) tsc - (before + (after - before) / 2.0));
+	}
+	return 0;
+}
@@ -0,0 +1,199 @@
+#include "clock_source.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: clock_source.cpp - Hold the code that picks and calibrates the hot-path clock.
+--
+-- PROGRAM: server, client, stats_reader
+--
+-- FUNCTIONS: static uint64_t monotonic_ns()
+--			  static uint64_t read_pair(uint64_t& tsc)
+--			  int ClockSource::calibrate()
+--			  bool ClockSource::invariant_tsc()
+--			  const char* ClockSource::name()
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Calibration runs once, while static objects are constructed, so every program linking this has its
+-- clock ready before main and before any thread starts.  It costs about 20ms of startup.
+----------------------------------------------------------------------------------------------------------------------*/
+
+int ClockSource::_source = CLOCK_SOURCE_MONOTONIC;
+uint64_t ClockSource::_base_tsc = 0;
+uint64_t ClockSource::_base_ns = 0;
+uint64_t ClockSource::_mult = 0;
+
+static int calibrated = ClockSource::calibrate();
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: monotonic_ns
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static uint64_t monotonic_ns()
+--
+-- RETURNS:  CLOCK_MONOTONIC in nanoseconds
+--
+-- NOTES: The reference the TSC is scaled to.
+----------------------------------------------------------------------------------------------------------------------*/
+static uint64_t monotonic_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#ifdef CLOCK_HAVE_TSC
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_pair
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static uint64_t read_pair(uint64_t& tsc)
+--					uint64_t& tsc - receives the TSC
+--
+-- RETURNS:  CLOCK_MONOTONIC in nanoseconds at the time of the TSC read
+--
+-- NOTES: The TSC is read between two clock reads, and the pair with the two closest together is kept; an
+-- interrupt or a preemption in between would otherwise put a skew of microseconds into the rate.
+----------------------------------------------------------------------------------------------------------------------*/
+static uint64_t read_pair(uint64_t& tsc)
+{
+	uint64_t best = ~0ULL, ns = 0;
+	for(int i = 0; i < CLOCK_BRACKET_TRIES; i++){
+		uint64_t before = monotonic_ns();
+		uint64_t t = __rdtsc();
+		uint64_t after = monotonic_ns();
+		if(after - before < best){
+			best = after - before;
+			ns = before + (after - before) / 2;
+			tsc = t;
+		}
+	}
+	return ns;
+}
+#endif
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: calibrate
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ClockSource::calibrate()
+--
+-- RETURNS:  the source picked
+--
+-- NOTES: Measures the TSC rate against CLOCK_MONOTONIC over CLOCK_CALIBRATE_NS and anchors it to the second
+-- reading, so TSC timestamps and CLOCK_MONOTONIC agree at startup and drift apart only by the error of the rate.
+-- Without an invariant TSC, or with a rate that makes no sense, CLOCK_MONOTONIC_COARSE is used.  Must run
+-- before any thread reads the clock.
+----------------------------------------------------------------------------------------------------------------------*/
+int ClockSource::calibrate()
+{
+	struct timespec res;
+#ifdef CLOCK_HAVE_TSC
+	if(invariant_tsc()){
+		uint64_t tsc0 = 0, tsc1 = 0;
+		const struct timespec interval {0, CLOCK_CALIBRATE_NS};
+		uint64_t ns0 = read_pair(tsc0);
+		nanosleep(&interval, NULL);
+		uint64_t ns1 = read_pair(tsc1);
+		if(tsc1 > tsc0 && ns1 > ns0){
+			double hz = (double)(tsc1 - tsc0) * 1e9 / (ns1 - ns0);
+			if(hz >= 1e8 && hz <= 1e11){
+				_mult = (uint64_t)(((unsigned __int128)(ns1 - ns0) << 32) / (tsc1 - tsc0));
+				_base_tsc = tsc1;
+				_base_ns = ns1;
+				_source = CLOCK_SOURCE_TSC;
+				return _source;
+			}
+		}
+	}
+#endif
+	_source = clock_getres(CLOCK_MONOTONIC_COARSE, &res) == 0 ? CLOCK_SOURCE_COARSE : CLOCK_SOURCE_MONOTONIC;
+	return _source;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: invariant_tsc
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: bool ClockSource::invariant_tsc()
+--
+-- RETURNS:  true if the CPU says its TSC runs at a constant rate through frequency and sleep states
+--
+-- NOTES: CPUID leaf 0x80000007, EDX bit 8.  Such a TSC is also kept in step across cores, so stamps taken on
+-- different threads can be subtracted.
+----------------------------------------------------------------------------------------------------------------------*/
+bool ClockSource::invariant_tsc()
+{
+#ifdef CLOCK_HAVE_TSC
+	unsigned int eax, ebx, ecx, edx;
+	if(__get_cpuid(0x80000000, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007){
+		return false;
+	}
+	__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+	return (edx & (1 << 8)) != 0;
+#else
+	return false;
+#endif
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: name
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: const char* ClockSource::name()
+--
+-- RETURNS:  the name of the source in use
+--
+-- NOTES: For the startup line and the benchmark.
+----------------------------------------------------------------------------------------------------------------------*/
+const char* ClockSource::name()
+{
+	switch(_source){
+		case CLOCK_SOURCE_TSC:
+			return "tsc";
+		case CLOCK_SOURCE_COARSE:
+			return "CLOCK_MONOTONIC_COARSE";
+		default:
+			return "CLOCK_MONOTONIC";
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef CLOCK_SOURCE_H
+#define CLOCK_SOURCE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#include <cpuid.h>
+#define CLOCK_HAVE_TSC 1
+#endif
+
+#define CLOCK_SOURCE_TSC 0			// invariant TSC, scaled to CLOCK_MONOTONIC nanoseconds
+#define CLOCK_SOURCE_COARSE 1		// CLOCK_MONOTONIC_COARSE, a tick (1-4ms) resolution
+#define CLOCK_SOURCE_MONOTONIC 2	// CLOCK_MONOTONIC, until the calibration is done
+
+#define CLOCK_CALIBRATE_NS 20000000	// time the TSC is measured against CLOCK_MONOTONIC at startup
+#define CLOCK_BRACKET_TRIES 16		// reads of a TSC/CLOCK_MONOTONIC pair, the tightest one is kept
+
+/**
+monotonic timestamps for the hot paths.  with an invariant TSC a read is one
+rdtsc and a multiply, scaled so it agrees with CLOCK_MONOTONIC at startup;
+otherwise it falls back to CLOCK_MONOTONIC_COARSE.  the source is picked
+before main runs and never changes, so threads read it without any locking.
+*/
+class ClockSource {
+
+public:
+	static inline uint64_t now_ns(){
+#ifdef CLOCK_HAVE_TSC
+		if(_source == CLOCK_SOURCE_TSC){
+			return _base_ns + (uint64_t)(((unsigned __int128)(__rdtsc() - _base_tsc) * _mult) >> 32);
+		}
+#endif
+		struct timespec ts;
+		clock_gettime(_source == CLOCK_SOURCE_COARSE ? CLOCK_MONOTONIC_COARSE : CLOCK_MONOTONIC, &ts);
+		return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	}
+	static inline uint64_t now_us() { return now_ns() / 1000; }
+
+	static int calibrate();
+	static int source() { return _source; }
+	static const char* name();
+	static double tsc_ghz() { return _mult != 0 ? 4294967296.0 / _mult : 0; }
+private:
+	static bool invariant_tsc();
+
+	static int _source;
+	static uint64_t _base_tsc;
+	static uint64_t _base_ns;
+	static uint64_t _mult;		// nanoseconds per tick, 32.32 fixed point
+};
+
+#endif
@@ -7,12 +7,32 @@
 --
 -- FUNCTIONS: Client::Client(char * host, int port, int t_sent)
 --			  int Client::run()
+--			  void * Client::process_slice(void * args)
+--			  int Client::start_msg(struct client_thread* t, struct client_conn* conn, uint64_t due)
+--			  int Client::flush_msg(struct client_conn* conn)
+--			  int Client::read_echoes(struct client_thread* t, struct client_conn* conn, char* buf, int len,
+--				uint64_t now)
+--			  int Client::echoed(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--			  int Client::top_up(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--			  uint64_t Client::issue_due(struct client_thread* t, uint64_t now)
+--			  uint64_t Client::start_connects(struct client_thread* t, uint64_t now)
+--			  void Client::open_conn(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--			  void Client::connected(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--			  void Client::connect_failed(struct client_thread* t, struct client_conn* conn, int err, uint64_t now)
+--			  void Client::arm_timer(struct client_thread* t, uint64_t when)
+--			  void Client::finish(struct client_thread* t, struct client_conn* conn)
+--			  void Client::report(const std::vector<struct client_thread>& threads, double elapsed)
+--			  int Client::resolve()
 --			  int Client::create_socket()
 --			  int Client::connect_to_server(int socket, char * host)
---			  int Client::send_msgs(int socket, char * data)
---			  int Client::recv_msgs(int socket, char * buf)
+--			  int Client::send_msgs(int socket, struct iovec * iov, int count)
+--			  int Client::recv_msgs(int socket, char * buf, int len)
 --			  int Client::setBufLen(int buflen)
 --			  int Client::setConnections(int connections)
+--			  int Client::setThreads(int threads)
+--			  int Client::setRate(double rate)
+--			  int Client::setConnectRate(double rate)
+--			  int Client::setDepth(int depth)
 --
 -- DATE: 2014/02/21
 --
@@ -46,7 +66,8 @@
 -- NOTES: Client constructor that will initialize the server host, port, and user-defined times the packets will be
 -- sent to the server.
 ----------------------------------------------------------------------------------------------------------------------*/
-Client::Client(char * host, int port, int t_sent) : _host(host), _port(port), times_sent(t_sent) {}
+Client::Client(char * host, int port, int t_sent) : _host(host), _port(port), times_sent(t_sent), _threads(1),
+	_rate(0), _connectRate(0), _depth(0), _payload(NULL) {}
 
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: run
@@ -54,6 +75,10 @@ Client::Client(char * host, int port, int t_sent) : _host(host), _port(port), ti
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - splits the connections over _threads threads, each with its own epoll instance, and
+--					 sends open loop at _rate messages per second when it is set
+--		2026/10/18 - every thread gets a timer and its share of the connect rate
+--		2026/10/18 - picks the pipeline depth when none was set
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -63,98 +88,816 @@ Client::Client(char * host, int port, int t_sent) : _host(host), _port(port), ti
 --
 -- RETURNS:  0 on success
 --
--- NOTES: Main echo client function that will create processes for multiple clients.
+-- NOTES: Main echo client function.  Resolves the server once, gives every thread an even slice of the
+-- connections and waits for them all to finish, then prints what each thread and the whole run did.  In open
+-- loop each thread gets the share of the rate its slice is of the connections, and the connect rate is split
+-- the same way.  Without a depth set, closed loop keeps one message in flight per connection and open loop
+-- up to CLIENT_INFLIGHT.
 ----------------------------------------------------------------------------------------------------------------------*/
 int Client::run()
-{	
-	int rtn;
-	char sendBuf[]={ "FOOBAR "};
-
-	char recvBuf[_buflen];
-	int nready, epoll_fd;
-	struct epoll_event events[_connections], event;
-	//Create multiple processes and each process will be a single client essentially
-
-	epoll_fd = epoll_create(_connections);
-	if (epoll_fd == -1) 
-		fprintf(stderr,"epoll_create\n");
-	// Add the server socket to the epoll event loop
-	for(int i = 0; i < _connections; i++){
-		//create clients and add to epoll
-		int clientSock = create_socket();
-		if(connect_to_server(clientSock, _host)<=0){
-			fprintf(stderr,"connect\n");
-				exit(1);
-		}
-		if (fcntl (clientSock, F_SETFL, O_NONBLOCK | fcntl (clientSock, F_GETFL, 0)) == -1) {
-			fprintf(stderr,"fcntl\n");
-				exit(1);
+{
+	if(_threads < 1){
+		_threads = 1;
+	}
+	if(_threads > _connections){
+		_threads = _connections;
+	}
+	if(resolve() < 0){
+		exit(1);
+	}
+	if(_depth <= 0){
+		_depth = _rate > 0 ? CLIENT_INFLIGHT : 1;
+	}
+	if(_buflen < CLIENT_STAMP){
+		fprintf(stderr, "buffer length raised to %d, the size of a message's stamp\n", CLIENT_STAMP);
+		_buflen = CLIENT_STAMP;
+	}
+	// the same bytes for every message, as long as the messages are
+	const char pattern[] = "FOOBAR ";
+	_payload = new char[_buflen];
+	for(int i = 0; i < _buflen; i++){
+		_payload[i] = pattern[i % (sizeof(pattern) - 1)];
+	}
+
+	std::vector<struct client_thread> threads(_threads);
+	for(int i = 0; i < _threads; i++){
+		threads[i].client = this;
+		threads[i].id = i;
+		threads[i].connections = _connections / _threads + (i < _connections % _threads ? 1 : 0);
+		threads[i].live = threads[i].connections;
+		threads[i].conns = NULL;
+		threads[i].started = 0;
+		threads[i].connecting = 0;
+		threads[i].retrying = 0;
+		threads[i].ramp_start_ns = 0;
+		threads[i].ramp_period_ns = _connectRate > 0 ? 1e9 * _connections / (_connectRate * threads[i].connections) : 0;
+		threads[i].ramp_end_ns = 0;
+		threads[i].cursor = 0;
+		threads[i].scheduled = 0;
+		threads[i].total = (long) threads[i].connections * times_sent;
+		threads[i].start_ns = 0;
+		threads[i].period_ns = _rate > 0 ? 1e9 * _connections / (_rate * threads[i].connections) : 0;
+		threads[i].max_lag = 0;
+		threads[i].stats = NULL;
+		if((threads[i].timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1){
+			perror("timerfd_create");
+			exit(1);
 		}
-		
-		if(clientSock >0){
-			event.events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET;
-			event.data.fd = clientSock;
-			if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, clientSock, &event) == -1) {
-				fprintf(stderr,"epoll_ctl\n");
-				exit(1);
-			}
-				
-			
-			rtn = send_msgs(clientSock, sendBuf);
-			ClientData::Instance()->recordData(clientSock, rtn);
+		threads[i].epoll_fd = epoll_create(threads[i].connections + 1);
+		if (threads[i].epoll_fd == -1){
+			fprintf(stderr,"epoll_create\n");
+			exit(1);
 		}
 	}
-	fflush(stderr);
-	
-	
-	
+	uint64_t start = stat_now_ns();
+	for(int i = 0; i < _threads; i++){
+		pthread_create(&threads[i].tid, NULL, process_slice, (void*)&threads[i]);
+	}
+	for(int i = 0; i < _threads; i++){
+		pthread_join(threads[i].tid, NULL);
+	}
+	report(threads, (stat_now_ns() - start) / 1e9);
+
+	LOG_INFO("All clients finished processing");
+	delete[] _payload;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_slice
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * Client::process_slice(void * args)
+--					void * args - the struct client_thread this thread runs
+--
+-- RETURNS:  0 when every connection of the slice is done or given up on
+--
+-- NOTES: Client thread.  Connects its slice without blocking, on the ramp schedule and with no more than
+-- CLIENT_CONNECTING connects in progress, and runs each connection once it is open until it has had times_sent
+-- messages echoed.  Closed loop, each connection sends its first _depth messages once connected and the next
+-- one whenever an echo comes back, so it always has _depth in flight until the last ones.  Open loop, the sends start once every connection of the slice has opened
+-- or been given up on, and follow the thread's schedule, on whichever connection has room.  The one timer wakes
+-- the thread for whichever of the next connect, retry or send is due first.  Connections are edge-triggered;
+-- only this thread ever reads or writes them.
+----------------------------------------------------------------------------------------------------------------------*/
+void * Client::process_slice(void * args)
+{
+	struct client_thread * t = (struct client_thread *) args;
+	Client * c = t->client;
+	int len = c->_buflen * CLIENT_INFLIGHT;
+	std::vector<char> recvBuf(len);
+	struct epoll_event events[CLIENT_EVENTS], event;
+	struct client_conn * conn;
+	int nready;
+	uint64_t now, next, due, expirations;
+
+	t->stats = ThreadStats::local();
+	ThreadStats::set_role("client");
+	t->conns = new struct client_conn[t->connections]();
+	for(int i = 0; i < t->connections; i++){
+		t->conns[i].fd = -1;
+		t->conns[i].state = CONN_WAITING;
+	}
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	if (epoll_ctl (t->epoll_fd, EPOLL_CTL_ADD, t->timer_fd, &event) == -1) {
+		fprintf(stderr,"epoll_ctl\n");
+		exit(1);
+	}
+	t->ramp_start_ns = now = stat_now_ns();
+
 	while(true){
-		
-		nready = epoll_wait (epoll_fd, events, _connections, -1);
-		for (int i = 0; i < nready; i++){	// check all clients for data
-			int sock = events[i].data.fd;
+		next = c->start_connects(t, now);
+		if(t->ramp_end_ns == 0 && t->started == t->connections && t->connecting == 0 && t->retrying == 0){
+			// every connection of the slice is open or given up on; open loop, the schedule starts
+			t->ramp_end_ns = now;
+			if(c->_rate > 0){
+				t->start_ns = now;
+			}
+		}
+		if(t->start_ns != 0 && (due = c->issue_due(t, now)) != 0 && (next == 0 || due < next)){
+			next = due;
+		}
+		if(t->live == 0){
+			break;
+		}
+		if(next != 0){
+			arm_timer(t, next);
+		}
+		nready = epoll_wait (t->epoll_fd, events, CLIENT_EVENTS, -1);
+		now = stat_now_ns();
+		ThreadStats::tick(now);
+		for (int i = 0; i < nready; i++){
+			conn = (struct client_conn *) events[i].data.ptr;
+			if(conn == NULL){
+				// the timer: the connects and sends that are due start at the top of the loop
+				if(read(t->timer_fd, &expirations, sizeof(expirations)) < 0 && errno != EAGAIN){
+					perror("timerfd read");
+				}
+				continue;
+			}
+			if(conn->state == CONN_CONNECTING){
+				// writable or in error: the connect is over either way
+				c->connected(t, conn, now);
+				continue;
+			}
+			if(conn->state != CONN_OPEN){
+				continue;
+			}
 			// Case 1: Error condition
-    		if (events[i].events & (EPOLLHUP | EPOLLERR)) {
-				fputs("epoll: EPOLLERR", stderr);
-
-				close(sock);
-				ClientData::Instance()->removeClient(sock);
+			if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+				LOG_WARN("epoll: EPOLLERR on socket %d", conn->fd);
+				c->finish(t, conn);
 				continue;
-    		}
-    		assert (events[i].events & EPOLLIN);
-    		// Case 2: One of the sockets has read data
-			int rtn = recv_msgs(sock, recvBuf);
-			if(rtn){
-				
-				//do rtt calc
-				ClientData::Instance()->setRtt(sock);
-				
 			}
-			else{
+			// Case 2: room to write the rest of a message, and closed loop the ones queued up behind it
+			if ((events[i].events & EPOLLOUT) && conn->unsent > 0) {
+				if(c->flush_msg(conn) < 0){
+					c->finish(t, conn);
+					continue;
+				}
+				if(c->_rate <= 0 && c->top_up(t, conn, now) < 0){
+					continue;
+				}
+			}
+			// Case 3: echoes to read
+			if (events[i].events & EPOLLIN) {
+				c->read_echoes(t, conn, recvBuf.data(), len, now);
+			}
+		}
+		now = stat_now_ns();
+	}
+	close(t->epoll_fd);
+	close(t->timer_fd);
+	delete[] t->conns;
+	t->conns = NULL;
+	return (void*)0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: start_connects
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Client::start_connects(struct client_thread* t, uint64_t now)
+--					struct client_thread* t - thread whose slice is connecting
+--					uint64_t now            - current time
+--
+-- RETURNS:  when the next connect or retry is due, 0 if none is waiting on the clock
+--
+-- NOTES: Retries the connections whose wait is over, then starts the connections the ramp has made due, as
+-- long as fewer than CLIENT_CONNECTING connects are in progress.  A connect held back by that limit is not due
+-- on the clock: the next connect to finish brings the thread back for it.  Without a connect rate the slice
+-- connects as fast as its connects complete.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Client::start_connects(struct client_thread* t, uint64_t now)
+{
+	struct client_conn * conn;
+	uint64_t next = 0, due;
+
+	for(int i = 0, waiting = t->retrying; i < t->started && waiting > 0; i++){
+		conn = &t->conns[i];
+		if(conn->state != CONN_WAITING){
+			continue;
+		}
+		waiting--;
+		if(conn->since > now){
+			if(next == 0 || conn->since < next){
+				next = conn->since;
+			}
+		} else if(t->connecting < CLIENT_CONNECTING){
+			t->retrying--;
+			open_conn(t, conn, now);
+		}
+	}
+	while(t->started < t->connections && t->connecting < CLIENT_CONNECTING){
+		due = t->ramp_start_ns + (uint64_t)(t->started * t->ramp_period_ns);
+		if(due > now){
+			if(next == 0 || due < next){
+				next = due;
+			}
+			break;
+		}
+		open_conn(t, &t->conns[t->started++], now);
+	}
+	return next;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: open_conn
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::open_conn(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection to try, not tried yet or due for a retry
+--					uint64_t now             - current time, what the connect is timed from
+--
+-- RETURNS:  void
+--
+-- NOTES: Starts a non-blocking connect and adds the socket to the thread's epoll instance, which reports it
+-- writable, or in error, when the connect is over.  A connect that finishes at once is handled on the spot.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::open_conn(struct client_thread* t, struct client_conn* conn, uint64_t now)
+{
+	struct epoll_event event;
+	int rc = 0, err;
+
+	conn->attempts++;
+	conn->since = now;
+	if((conn->fd = create_socket()) < 0 || (rc = connect_to_server(conn->fd, _host)) < 0){
+		connect_failed(t, conn, errno, now);
+		return;
+	}
+	event.events = EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP | EPOLLET;
+	event.data.ptr = conn;
+	if (epoll_ctl (t->epoll_fd, EPOLL_CTL_ADD, conn->fd, &event) == -1) {
+		err = errno;
+		perror("epoll_ctl");
+		connect_failed(t, conn, err, now);
+		return;
+	}
+	conn->state = CONN_CONNECTING;
+	t->connecting++;
+	if(rc == 0){
+		connected(t, conn, now);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connected
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::connected(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection whose connect is over
+--					uint64_t now             - when epoll_wait returned, the time the connect finished by
+--
+-- RETURNS:  void
+--
+-- NOTES: SO_ERROR tells whether the connect worked.  An open connection records the time since its connect()
+-- call in the connect histogram, joins the client table and, closed loop, sends its first messages.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::connected(struct client_thread* t, struct client_conn* conn, uint64_t now)
+{
+	char address[INET_ADDRSTRLEN];
+	int err = 0;
+	socklen_t len = sizeof(err);
+
+	t->connecting--;
+	if(getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1){
+		err = errno;
+	}
+	if(err != 0){
+		connect_failed(t, conn, err, now);
+		return;
+	}
+	conn->state = CONN_OPEN;
+	stat_add(t->stats->connects, 1);
+	t->stats->connect.record(now > conn->since ? (now - conn->since) / 1000 : 0);
+	inet_ntop(AF_INET, &_server.sin_addr, address, sizeof(address));
+	ClientData::Instance()->addClient(conn->fd, address, _server.sin_port);
+	if(_rate <= 0){
+		top_up(t, conn, now);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: connect_failed
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::connect_failed(struct client_thread* t, struct client_conn* conn, int err, uint64_t now)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection whose connect failed
+--					int err                  - the errno of the failure
+--					uint64_t now             - current time
+--
+-- RETURNS:  void
+--
+-- NOTES: Closes the socket.  Refused, reset and timed out connects are what a server with a full backlog gives
+-- back, and running out of ports or buffers is what a client gets when it opens connections faster than the old
+-- ones go away, so those are tried again after CLIENT_RETRY_NS, doubled for every retry, up to
+-- CLIENT_CONNECT_TRIES attempts in all.  Any other error gives the connection up, and the test goes on without it.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::connect_failed(struct client_thread* t, struct client_conn* conn, int err, uint64_t now)
+{
+	if(conn->fd >= 0){
+		close(conn->fd);
+		conn->fd = -1;
+	}
+	bool transient = err == ECONNREFUSED || err == ECONNRESET || err == ECONNABORTED || err == ETIMEDOUT
+		|| err == EAGAIN || err == EADDRNOTAVAIL || err == ENOBUFS || err == EHOSTUNREACH || err == ENETUNREACH;
+	if(transient && conn->attempts < CLIENT_CONNECT_TRIES){
+		conn->state = CONN_WAITING;
+		conn->since = now + ((uint64_t) CLIENT_RETRY_NS << (conn->attempts - 1));
+		t->retrying++;
+		stat_add(t->stats->connect_retries, 1);
+		LOG_DEBUG("connect attempt %d failed with error %d, retrying", conn->attempts, err);
+		return;
+	}
+	LOG_WARN("connect failed with error %d after %d attempts, giving the connection up", err, conn->attempts);
+	conn->state = CONN_CLOSED;
+	stat_add(t->stats->connect_failures, 1);
+	t->live--;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: arm_timer
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::arm_timer(struct client_thread* t, uint64_t when)
+--					struct client_thread* t - thread to wake
+--					uint64_t when           - stat_now_ns() time to wake it at
+--
+-- RETURNS:  void
+--
+-- NOTES: The hot-path clock is the TSC scaled to nanoseconds, which drifts away from CLOCK_MONOTONIC over a
+-- run, so the timer is set to go off relative to now rather than at an absolute time.  A time already past
+-- fires the timer straight away.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::arm_timer(struct client_thread* t, uint64_t when)
+{
+	struct itimerspec timer;
+	uint64_t now = stat_now_ns();
+	// 0 would disarm the timer
+	uint64_t delay = when > now ? when - now : 1;
+
+	memset(&timer, 0, sizeof(timer));
+	timer.it_value.tv_sec = delay / 1000000000ULL;
+	timer.it_value.tv_nsec = delay % 1000000000ULL;
+	if(timerfd_settime(t->timer_fd, 0, &timer, NULL) == -1){
+		perror("timerfd_settime");
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: start_msg
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::start_msg(struct client_thread* t, struct client_conn* conn, uint64_t due)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection to send on, with room for another message in flight
+--					uint64_t due             - when the message was due to be sent, what its latency counts from
+--
+-- RETURNS:  0 on success, -1 if the connection failed and was closed
+--
+-- NOTES: Stamps the message with its number, the time and its due time, then writes as much of it as the
+-- socket takes; EPOLLOUT brings the rest.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::start_msg(struct client_thread* t, struct client_conn* conn, uint64_t due)
+{
+	conn->out.seq = conn->sent;
+	conn->out.sent_ns = stat_now_ns();
+	conn->out.due_ns = due;
+	conn->sent++;
+	conn->unsent = _buflen;
+	if(flush_msg(conn) < 0){
+		finish(t, conn);
+		return -1;
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: flush_msg
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::flush_msg(struct client_conn* conn)
+--					struct client_conn* conn - connection with part of a message left to write
+--
+-- RETURNS:  0 when the message is written or the socket is full, -1 on a send error
+--
+-- NOTES: Every message is the connection's stamp over the front of the same payload, so the bytes left are
+-- whatever of the stamp is left and the payload's tail.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::flush_msg(struct client_conn* conn)
+{
+	struct iovec iov[2];
+	int n, count, at;
+	while(conn->unsent > 0){
+		at = _buflen - conn->unsent;
+		count = 0;
+		if(at < CLIENT_STAMP){
+			iov[count].iov_base = (char*)&conn->out + at;
+			iov[count++].iov_len = CLIENT_STAMP - at;
+			at = CLIENT_STAMP;
+		}
+		if(at < _buflen){
+			iov[count].iov_base = _payload + at;
+			iov[count++].iov_len = _buflen - at;
+		}
+		if((n = send_msgs(conn->fd, iov, count)) < 0){
+			if(errno == EINTR){
 				continue;
 			}
-			//do # client sent calc
-			if(ClientData::Instance()->getNumRequest(sock) < times_sent){
-				rtn = send_msgs(sock, sendBuf);
-				ClientData::Instance()->recordData(sock, rtn);
-			} else {
-				//met quota for sending packets to server. close connection
-				ClientData::Instance()->removeClient(sock);
-				close(sock);
-				
+			if(errno == EAGAIN || errno == EWOULDBLOCK){
+				return 0;
 			}
- 		}
-		if(ClientData::Instance()->empty()){
+			LOG_WARN("send error %d on socket %d", errno, conn->fd);
+			return -1;
+		}
+		conn->unsent -= n;
+		ClientData::Instance()->recordData(conn->fd, n);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_echoes
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::read_echoes(struct client_thread* t, struct client_conn* conn, char* buf, int len,
+--				uint64_t now)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection epoll says has data
+--					char* buf                - scratch buffer for the echoes
+--					int len                  - size of buf
+--					uint64_t now             - when epoll_wait returned, the time the echoes arrived by
+--
+-- RETURNS:  0 on success, -1 if the connection is done or failed and was closed
+--
+-- NOTES: Reads until the socket is empty, as edge triggering needs, and frames the echoes itself: an echo
+-- split over two reads is completed by the second, and the stamp at its front is kept as it goes by.  A
+-- connection the server closes, or whose recv fails, is finished early and counts as lost.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::read_echoes(struct client_thread* t, struct client_conn* conn, char* buf, int len, uint64_t now)
+{
+	int n, take;
+	while((n = recv_msgs(conn->fd, buf, len)) > 0){
+		for(char * p = buf; p < buf + n; p += take){
+			take = std::min((int)(buf + n - p), _buflen - conn->in);
+			if(conn->in < CLIENT_STAMP){
+				memcpy((char*)&conn->back + conn->in, p, std::min(take, CLIENT_STAMP - conn->in));
+			}
+			conn->in += take;
+			if(conn->in == _buflen){
+				conn->in = 0;
+				if(conn->done < conn->sent && echoed(t, conn, now) < 0){
+					return -1;
+				}
+			}
+		}
+		if(n < len){
 			break;
 		}
-	
 	}
-	
+	if(n < 0){
+		finish(t, conn);
+		return -1;
+	}
+	if(conn->done >= times_sent){
+		//met quota for sending packets to server. close connection
+		finish(t, conn);
+		return -1;
+	}
+	return 0;
+}
 
-	std::cout << "All clients finished processing" << std::endl;
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: echoed
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::echoed(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection whose oldest message in flight was echoed in full
+--					uint64_t now             - when epoll_wait returned, the time the echo arrived by
+--
+-- RETURNS:  0 on success, -1 if the next message failed and the connection was closed
+--
+-- NOTES: Times the echo by the stamp it brought back: its latency from the due time and its request time from
+-- the send time.  A stamp that is not the next message's means the server lost, reordered or mangled bytes;
+-- it is counted and not timed, since its times cannot be trusted.  Closed loop, each echo makes room for the
+-- next message, which goes out right away.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::echoed(struct client_thread* t, struct client_conn* conn, uint64_t now)
+{
+	if(conn->back.seq == (uint64_t) conn->done){
+		t->stats->latency.record(now > conn->back.due_ns ? (now - conn->back.due_ns) / 1000 : 0);
+		t->stats->request.record(now > conn->back.sent_ns ? (now - conn->back.sent_ns) / 1000 : 0);
+	} else {
+		stat_add(t->stats->echo_mismatches, 1);
+		LOG_WARN("echo %d on socket %d came back stamped %lu", conn->done, conn->fd, (unsigned long) conn->back.seq);
+	}
+	conn->done++;
+	//do rtt calc
+	ClientData::Instance()->setRtt(conn->fd);
+	if(_rate <= 0){
+		return top_up(t, conn, now);
+	}
 	return 0;
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: top_up
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::top_up(struct client_thread* t, struct client_conn* conn, uint64_t now)
+--					struct client_thread* t - closed loop thread that owns the connection
+--					struct client_conn* conn - open connection
+--					uint64_t now             - the time that let the messages go, their due time
+--
+-- RETURNS:  0 on success, -1 if a send failed and the connection was closed
+--
+-- NOTES: Starts messages, one behind the other without waiting for echoes, until the connection has _depth in
+-- flight, has started its last one or its socket is full; EPOLLOUT brings it back for the rest then.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::top_up(struct client_thread* t, struct client_conn* conn, uint64_t now)
+{
+	while(conn->sent < times_sent && conn->unsent == 0 && conn->sent - conn->done < _depth){
+		if(start_msg(t, conn, now) < 0){
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: issue_due
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Client::issue_due(struct client_thread* t, uint64_t now)
+--					struct client_thread* t - open loop thread
+--					uint64_t now            - current time
+--
+-- RETURNS:  when the next send is due, 0 if there is none or no connection has room for it
+--
+-- NOTES: Hands every send that is due to the next open connection with room for it.  A send goes out late, but
+-- keeps its due time, when the thread fell behind or every connection already has _depth messages
+-- unanswered; in the second case the timer is not wanted and the next echo brings the thread back.  So a server
+-- that stalls gets its stall counted against every send it held up, rather than the client quietly sending less.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Client::issue_due(struct client_thread* t, uint64_t now)
+{
+	while(t->scheduled < t->total){
+		uint64_t due = t->start_ns + (uint64_t)(t->scheduled * t->period_ns);
+		if(due > now){
+			return due;
+		}
+		struct client_conn * conn = NULL;
+		for(int i = 0; i < t->connections && conn == NULL; i++){
+			struct client_conn * next = &t->conns[(t->cursor + i) % t->connections];
+			if(next->state == CONN_OPEN && next->sent < times_sent && next->unsent == 0
+				&& next->sent - next->done < _depth){
+				conn = next;
+				t->cursor = (t->cursor + i + 1) % t->connections;
+			}
+		}
+		if(conn == NULL){
+			return 0;
+		}
+		if(now - due > t->max_lag){
+			t->max_lag = now - due;
+		}
+		t->scheduled++;
+		start_msg(t, conn, due);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: finish
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::finish(struct client_thread* t, struct client_conn* conn)
+--					struct client_thread* t - thread that owns the connection
+--					struct client_conn* conn - connection that is done or failed
+--
+-- RETURNS:  void
+--
+-- NOTES: Closes the connection and takes it out of the thread's count, counting it as lost if it had echoes
+-- still to read.  Events already returned for it in the same batch are skipped by its state.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::finish(struct client_thread* t, struct client_conn* conn)
+{
+	if(conn->done < times_sent){
+		stat_add(t->stats->conns_lost, 1);
+	}
+	ClientData::Instance()->removeClient(conn->fd);
+	close(conn->fd);
+	conn->fd = -1;
+	conn->state = CONN_CLOSED;
+	t->live--;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: report
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Client::report(const std::vector<struct client_thread>& threads, double elapsed)
+--					const std::vector<struct client_thread>& threads - the joined client threads
+--					double elapsed                                   - seconds from the start to the last join
+--
+-- RETURNS:  void
+--
+-- NOTES: One line per thread from its own stats block, and one merging them all, with the pipeline depth the
+-- throughput and latency were had at.  A thread that did much
+-- less than the others had a slower share of the connections, or the machine ran short of cores.  Latency is
+-- from when each message was due to when its echo was read, and request time from when it was sent, both by
+-- the stamp the echo brought back; RTT is still the time between two echoes on a connection.  Open loop adds
+-- the rate asked for and how late the client itself sent, which if large means the client, not the server,
+-- could not keep up.  The connect line counts the connects/s over the ramp, from the first connect to the
+-- last connection opened or given up on, how long the connects took, and the connections lost before their
+-- last echo.
+----------------------------------------------------------------------------------------------------------------------*/
+void Client::report(const std::vector<struct client_thread>& threads, double elapsed)
+{
+	HistogramSnapshot rtt, latency, all, allLatency, request, connect;
+	uint64_t messages = 0, bytes = 0, lag = 0, mismatches = 0, connects = 0, retries = 0, failures = 0, lost = 0;
+	uint64_t rampStart = 0, rampEnd = 0;
+
+	if(elapsed <= 0){
+		elapsed = 1;
+	}
+	all.clear();
+	allLatency.clear();
+	request.clear();
+	connect.clear();
+	for(size_t i = 0; i < threads.size(); i++){
+		const struct client_thread& t = threads[i];
+		if(t.stats == NULL){
+			continue;
+		}
+		uint64_t m = t.stats->messages.load(std::memory_order_relaxed);
+		rtt.clear();
+		latency.clear();
+		t.stats->rtt.add_to(rtt);
+		t.stats->latency.add_to(latency);
+		all.add(rtt);
+		allLatency.add(latency);
+		messages += m;
+		bytes += t.stats->bytes.load(std::memory_order_relaxed);
+		lag = std::max(lag, t.max_lag);
+		t.stats->request.add_to(request);
+		t.stats->connect.add_to(connect);
+		mismatches += t.stats->echo_mismatches.load(std::memory_order_relaxed);
+		connects += t.stats->connects.load(std::memory_order_relaxed);
+		retries += t.stats->connect_retries.load(std::memory_order_relaxed);
+		failures += t.stats->connect_failures.load(std::memory_order_relaxed);
+		lost += t.stats->conns_lost.load(std::memory_order_relaxed);
+		rampStart = rampStart == 0 ? t.ramp_start_ns : std::min(rampStart, t.ramp_start_ns);
+		rampEnd = std::max(rampEnd, t.ramp_end_ns);
+		printf("thread %d: connections: %d \tmsgs: %lu \tmsgs/s: %.0lf \tlatency(us) p50: %lu \tp99: %lu \tmax: %lu\n",
+			t.id, t.connections, (unsigned long) m, m / elapsed, (unsigned long) latency.percentile(50),
+			(unsigned long) latency.percentile(99), (unsigned long) latency.max());
+	}
+	printf("total: threads: %d \tconnections: %d \tdepth: %d \tmsgs: %lu \tmsgs/s: %.0lf \tbytes/s: %.0lf \ttime(s): %.2lf"
+		" \tRTT(us) p50: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu\n", (int) threads.size(), _connections, _depth,
+		(unsigned long) messages, messages / elapsed, bytes / elapsed, elapsed, (unsigned long) all.percentile(50),
+		(unsigned long) all.percentile(99), (unsigned long) all.percentile(99.9), (unsigned long) all.max());
+	printf("latency(us) p50: %lu \tp90: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu \tcount: %lu\n",
+		(unsigned long) allLatency.percentile(50), (unsigned long) allLatency.percentile(90),
+		(unsigned long) allLatency.percentile(99), (unsigned long) allLatency.percentile(99.9),
+		(unsigned long) allLatency.max(), (unsigned long) allLatency.total());
+	printf("request(us) p50: %lu \tp90: %lu \tp99: %lu \tp99.9: %lu \tmax: %lu \tcount: %lu \tmismatched echoes: %lu\n",
+		(unsigned long) request.percentile(50), (unsigned long) request.percentile(90),
+		(unsigned long) request.percentile(99), (unsigned long) request.percentile(99.9),
+		(unsigned long) request.max(), (unsigned long) request.total(), (unsigned long) mismatches);
+	double ramp = rampEnd > rampStart ? (rampEnd - rampStart) / 1e9 : 0;
+	printf("connects: %lu 	retries: %lu 	failed: %lu 	lost: %lu 	connects/s: %.0lf 	ramp(s): %.2lf"
+		" 	connect(us) p50: %lu 	p99: %lu 	p99.9: %lu 	max: %lu\n", (unsigned long) connects, (unsigned long) retries,
+		(unsigned long) failures, (unsigned long) lost, ramp > 0 ? connects / ramp : 0.0, ramp, (unsigned long) connect.percentile(50),
+		(unsigned long) connect.percentile(99), (unsigned long) connect.percentile(99.9), (unsigned long) connect.max());
+	if(_rate > 0){
+		printf("open loop: target msgs/s: %.0lf \tsend lag max(us): %lu\n", _rate, (unsigned long)(lag / 1000));
+	}
+	fflush(stdout);
+}
 
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: create_socket
@@ -162,6 +905,8 @@ int Client::run()
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - the socket is non-blocking from the start, and a failure is returned rather than exiting
+--		2026/10/18 - sets TCP_NODELAY
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -169,19 +914,19 @@ int Client::run()
 --
 -- INTERFACE: int Client::create_socket()
 --
--- RETURNS:  Socket Descriptor
+-- RETURNS:  Socket Descriptor, -1 with errno set on failure
 --
--- NOTES: Creates a socket and returns the socket descriptor on successful creation.
+-- NOTES: Creates a non-blocking socket with Nagle off and returns the socket descriptor on successful creation.
 ----------------------------------------------------------------------------------------------------------------------*/
 int Client::create_socket()
 {
-	int sd;
+	int sd, one = 1;
 
 	// Create the socket
-	if ((sd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
-	{
-		perror("Cannot create socket");
-		exit(1);
+	sd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+	// pipelined messages go out back to back; Nagle would hold each behind the ack of the last
+	if (sd != -1 && setsockopt(sd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)) == -1){
+		perror("setsockopt TCP_NODELAY");
 	}
 	return sd;
 	
@@ -193,6 +938,8 @@ int Client::create_socket()
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - connects to the address resolve() found, callable from any client thread
+--		2026/10/18 - only starts the connect; the caller finishes it and adds the client to the table
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -200,42 +947,55 @@ int Client::create_socket()
 --
 -- INTERFACE: int Client::connect_to_server(int socket, char * host)
 --					    int socket - client socket passed in
---					    char * host - server host IP
+--					    char * host - server host IP, already resolved by run()
 --
--- RETURNS:  0 if failure to connect to server, client socket on success
+-- RETURNS:  0 if connected already, 1 if the connect is in progress, -1 with errno set if it failed
 --
--- NOTES: Function that the client will try to connect to the server.
+-- NOTES: Function that the client will try to connect to the server, on a non-blocking socket.  gethostbyname
+-- and inet_ntoa keep their results in static buffers, so neither is called here any more.
 ----------------------------------------------------------------------------------------------------------------------*/
 int Client::connect_to_server(int socket, char * host)
 {
-	struct sockaddr_in server;
-	struct hostent	*hostptr;
-
+	struct sockaddr_in server = _server;
 
-
-	bzero((char *)&server, sizeof(struct sockaddr_in));
-	server.sin_family = AF_INET;
-	server.sin_port = htons(_port);
-	if ((hostptr = gethostbyname(host)) == NULL)
+	if (connect (socket, (struct sockaddr *)&server, sizeof(server)) == -1)
 	{
-		fprintf(stderr, "Unknown server address\n");
-		exit(1);
+		return errno == EINPROGRESS ? 1 : -1;
 	}
-	bcopy(hostptr->h_addr, (char *)&server.sin_addr, hostptr->h_length);
+	return 0;
+}
 
-	if (connect (socket, (struct sockaddr *)&server, sizeof(server)) == -1)
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: resolve
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::resolve()
+--
+-- RETURNS:  0 on success, -1 if the host is unknown
+--
+-- NOTES: Looks the server up once, before the client threads start, and keeps the address for every connect.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::resolve()
+{
+	struct hostent	*hostptr;
+
+	bzero((char *)&_server, sizeof(struct sockaddr_in));
+	_server.sin_family = AF_INET;
+	_server.sin_port = htons(_port);
+	if (_host == NULL || (hostptr = gethostbyname(_host)) == NULL)
 	{
-		fprintf(stderr, "Can't connect to server\n");
-		fflush(stderr);
-		perror("connect");
-		exit(1);
-		return 0;
-	}
-	if(socket > 0){
-		ClientData::Instance()->addClient(socket, inet_ntoa(server.sin_addr),server.sin_port );
+		fprintf(stderr, "Unknown server address\n");
+		return -1;
 	}
-
-	return socket;
+	bcopy(hostptr->h_addr, (char *)&_server.sin_addr, hostptr->h_length);
+	return 0;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -244,22 +1004,31 @@ int Client::connect_to_server(int socket, char * host)
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - sends len bytes, which may be the tail of a message
+--		2026/10/18 - sends a gather list, the stamp and the payload
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: int Client::send_msgs(int socket, char * data)
+-- INTERFACE: int Client::send_msgs(int socket, struct iovec * iov, int count)
 --				    int socket - client socket that the data is sending from
---				    char * data - data that the client is sending to the server
+--				    struct iovec * iov - data that the client is sending to the server
+--				    int count - number of buffers in iov
 --
--- RETURNS:  Returns how many bytes the client sent to the server.
+-- RETURNS:  Returns how many bytes the client sent to the server, -1 on error.
 --
--- NOTES: This function will send messages to the server with the client socket passed in.
+-- NOTES: This function will send messages to the server with the client socket passed in, gathering the
+-- stamp and the payload in one call.  A server that went away does not raise SIGPIPE.
 ----------------------------------------------------------------------------------------------------------------------*/
-int Client::send_msgs(int socket, char * data)
+int Client::send_msgs(int socket, struct iovec * iov, int count)
 {
-	return send(socket, data, _buflen, 0);
+	struct msghdr msg;
+
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = count;
+	return sendmsg(socket, &msg, MSG_NOSIGNAL);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -268,48 +1037,40 @@ int Client::send_msgs(int socket, char * data)
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - reads whatever is there, up to len bytes; read_echoes does the framing
+--		2026/10/18 - leaves a closed or failed connection to the caller rather than exiting
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: int Client::recv_msgs(int socket, char * buf)
+-- INTERFACE: int Client::recv_msgs(int socket, char * buf, int len)
 --				    int socket - client socket passed in
 --				    char * buf - data that the client is receiving from the server
+--				    int len - size of buf
 --
--- RETURNS:  Returns the total bytes read.
+-- RETURNS:  Returns the bytes read, 0 if there is nothing to read, -1 if the server closed the connection or
+-- the recv failed.
 --
--- NOTES: This function will receive messages from the server with the client socket passed in.
+-- NOTES: This function will receive messages from the server with the client socket passed in.  The socket is
+-- left open for the caller to close.
 ----------------------------------------------------------------------------------------------------------------------*/
-int Client::recv_msgs(int socket, char * buf)
+int Client::recv_msgs(int socket, char * buf, int len)
 {
-	
-	int n, bytes_to_read = _buflen;
-	while ((n = recv (socket, buf, bytes_to_read, 0)) < bytes_to_read)
-	{
-		
-		if(n == -1){
-			if (errno == EAGAIN || errno == EWOULDBLOCK) {
-				break;
-			}
-			printf("error %d %d %d\n", bytes_to_read, n, socket);
-			printf("error %d\n",errno);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
-				exit(1);
-			return -1;
-		} else if (n == 0){
-			printf("socket was gracefully closed by other side %d\n",socket);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
-				exit(1);
-			return -1;
+	int n;
+	while ((n = recv (socket, buf, len, 0)) < 0 && errno == EINTR);
+
+	if(n == -1){
+		if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			return 0;
 		}
-		buf += n;
-		bytes_to_read -= n;
+		LOG_WARN("recv error %d on socket %d, %d bytes to read", errno, socket, len);
+		return -1;
+	} else if (n == 0){
+		LOG_INFO("socket was gracefully closed by other side %d", socket);
+		return -1;
 	}
-
-	return 1;
+	return n;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -359,3 +1120,95 @@ int Client::setConnections(int connections){
 	_connections = connections;
 	return 1;
 }
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setThreads
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::setThreads(int threads)
+--				    int threads - number of client threads, each with its own epoll instance
+--
+-- RETURNS:  1
+--
+-- NOTES: sets the number of client threads; run() keeps it between 1 and the number of connections.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::setThreads(int threads){
+	_threads = threads;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setRate
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::setRate(double rate)
+--				    double rate - messages per second over all connections, 0 for closed loop
+--
+-- RETURNS:  1
+--
+-- NOTES: sets the open loop send rate.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::setRate(double rate){
+	_rate = rate > 0 ? rate : 0;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setConnectRate
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::setConnectRate(double rate)
+--				    double rate - connects per second over all threads, 0 for as fast as they complete
+--
+-- RETURNS:  1
+--
+-- NOTES: sets the rate the connections ramp up at.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::setConnectRate(double rate){
+	_connectRate = rate > 0 ? rate : 0;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setDepth
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Client::setDepth(int depth)
+--				    int depth - messages each connection keeps in flight, 0 for the default
+--
+-- RETURNS:  1
+--
+-- NOTES: sets the pipeline depth, at most CLIENT_INFLIGHT.
+----------------------------------------------------------------------------------------------------------------------*/
+int Client::setDepth(int depth){
+	_depth = std::min(std::max(depth, 0), CLIENT_INFLIGHT);
+	return 1;
+}
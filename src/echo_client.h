@@ -3,12 +3,15 @@
 
 #include "client_data.h"
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 #include <stdio.h>
 #include <netdb.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <strings.h>
@@ -19,12 +22,90 @@
 #include <pthread.h>
 #include <sys/wait.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <assert.h>
 #include <fcntl.h>
 #include <cstring>
 
 #define SERVER_TCP_PORT		7000	// Default port
 #define MAX_CONNECT		100	// Max number of connections to server
+#define CLIENT_EVENTS	1024	// events a client thread takes per epoll_wait
+#define CLIENT_INFLIGHT	64		// most messages a connection can have unanswered: the deepest pipeline, and open loop's default
+#define CLIENT_CONNECTING	256		// connects a thread has in progress at once
+#define CLIENT_CONNECT_TRIES	6		// attempts at a connection before it counts as failed
+#define CLIENT_RETRY_NS	10000000	// wait before the first retry of a connect, doubled for each one after
+
+#define CONN_WAITING	0		// not tried yet, or waiting to retry
+#define CONN_CONNECTING	1		// non-blocking connect in progress
+#define CONN_OPEN		2
+#define CONN_CLOSED		3		// done, or failed for good
+
+class Client;
+
+/**
+written over the front of every message and echoed back with it, so an echo
+says which message it answers and when that one went out.  host order: only
+the client that wrote a stamp reads it.
+*/
+struct client_stamp {
+	uint64_t seq;			// number of the message on its connection
+	uint64_t sent_ns;		// stat_now_ns() when the message was started
+	uint64_t due_ns;		// when it was due: the send time, or open loop its time on the schedule
+};
+
+#define CLIENT_STAMP	((int) sizeof(struct client_stamp))	// smallest message the client sends
+
+/**
+one connection of a client thread.  every message is _buflen bytes and the
+server echoes them in order, so each full _buflen read answers the oldest
+message in flight; the stamp at its front is checked against that.
+*/
+struct client_conn {
+	int fd;					// -1 unless connecting or open
+	int state;				// CONN_*
+	int attempts;			// connects tried so far
+	uint64_t since;			// connecting: when connect() was called; waiting to retry: when the retry is due
+	int sent;				// messages started
+	int done;				// echoes read in full
+	int unsent;				// bytes of the last message started still to write
+	int in;					// bytes of the next echo already read
+	struct client_stamp out;	// stamp of the last message started
+	struct client_stamp back;	// stamp of the echo being read, as far as it has come
+};
+
+/**
+one load thread.  it owns an epoll instance and a slice of the connections,
+and runs them until every one has sent its messages.  its counts go to its
+own stats block, which the summary reads after the thread is joined.  the
+connects ramp up on a schedule too when a rate is set: connection k is
+started at ramp_start_ns + k * ramp_period_ns.  in open loop the thread sends
+on a schedule of its own: send k is due at start_ns + k * period_ns, whether
+or not the echoes keep up.
+*/
+struct client_thread {
+	pthread_t tid;
+	Client* client;
+	int epoll_fd;
+	int timer_fd;			// fires when the next connect, retry or open loop send is due
+	int id;
+	int connections;		// size of the slice
+	int live;				// connections of the slice not yet done or failed, thread only
+	struct client_conn* conns;
+	int started;			// connections tried at least once
+	int connecting;			// connects in progress
+	int retrying;			// connections waiting to retry
+	uint64_t ramp_start_ns;	// when connection 0 was started
+	double ramp_period_ns;	// time between two connects of this thread, 0 for as fast as they complete
+	uint64_t ramp_end_ns;	// when the last connection of the slice opened or failed
+	int cursor;				// open loop: connection the next send is tried on first
+	long scheduled;			// open loop: sends handed out by the schedule
+	long total;				// sends the slice makes in all
+	uint64_t start_ns;		// open loop: when send 0 was due
+	double period_ns;		// open loop: time between two sends of this thread
+	uint64_t max_lag;		// open loop: longest a send went out after it was due, in nanoseconds
+	thread_stats* stats;
+};
 
 class Client {
 
@@ -35,13 +116,38 @@ public:
 	int create_socket();
 
 	int connect_to_server(int socket, char * host);
-	int send_msgs(int socket, char * data);
-	int recv_msgs(int socket, char * buf);
+	int send_msgs(int socket, struct iovec * iov, int count);
+	int recv_msgs(int socket, char * buf, int len);
 	int setBufLen(int buflen);
 	int setConnections(int connections);
+	int setThreads(int threads);
+	int setRate(double rate);
+	int setConnectRate(double rate);
+	int setDepth(int depth);
 private:
+	int resolve();
+	void report(const std::vector<struct client_thread>& threads, double elapsed);
+	static void * process_slice(void * args);
+	int start_msg(struct client_thread* t, struct client_conn* conn, uint64_t due);
+	int flush_msg(struct client_conn* conn);
+	int read_echoes(struct client_thread* t, struct client_conn* conn, char* buf, int len, uint64_t now);
+	int echoed(struct client_thread* t, struct client_conn* conn, uint64_t now);
+	int top_up(struct client_thread* t, struct client_conn* conn, uint64_t now);
+	uint64_t issue_due(struct client_thread* t, uint64_t now);
+	uint64_t start_connects(struct client_thread* t, uint64_t now);
+	void open_conn(struct client_thread* t, struct client_conn* conn, uint64_t now);
+	void connected(struct client_thread* t, struct client_conn* conn, uint64_t now);
+	void connect_failed(struct client_thread* t, struct client_conn* conn, int err, uint64_t now);
+	static void arm_timer(struct client_thread* t, uint64_t when);
+	void finish(struct client_thread* t, struct client_conn* conn);
+
 	char * _host;
-	int _port, times_sent, _buflen, _connections;
+	int _port, times_sent, _buflen, _connections, _threads;
+	double _rate;					// messages per second over all connections, 0 for closed loop
+	double _connectRate;			// connects per second over all threads, 0 for no limit
+	int _depth;						// messages a connection keeps in flight, 0 until run() picks the default
+	struct sockaddr_in _server;		// resolved once, before the threads start
+	char * _payload;				// _buflen bytes every connection sends
 
 };
 
@@ -11,14 +11,24 @@
 --			  int EpollServer::create_socket()
 --			  int EpollServer::bind_socket()
 --			  void EpollServer::listen_for_clients()
---			  int EpollServer::accept_client()
---			  void EpollServer::send_msgs(int socket, char * data)
+--			  int EpollServer::accept_clients()
+--			  int EpollServer::send_msgs(int socket, char * data, int len)
 --			  int EpollServer::recv_msgs(int socket, char * bp)
+--			  int EpollServer::splice_msgs(int socket, int pipefd[2], char * bp)
 --			  int EpollServer::set_sock_option(int listenSocket)
+--			  int EpollServer::arm_client(uint64_t token)
+--			  int EpollServer::close_client(int socket)
 --			  void * EpollServer::process_client(void * args)
+--			  void * EpollServer::process_accept(void * args)
+--			  void EpollServer::reap(std::vector<struct zc_grave>& graveyard)
 --			  int EpollServer::set_port(int port)
 --			  int EpollServer::set_num_threads(int num)
 --			  int EpollServer::setBufLen(int buflen)
+--			  int EpollServer::set_backlog(int backlog)
+--			  int EpollServer::set_accept_threads(int num)
+--			  int EpollServer::set_splice(bool on)
+--			  int EpollServer::set_zerocopy(int threshold)
+--			  void EpollServer::queue_stats(stats_snapshot& snap, bool reset)
 --
 --
 -- DATE: 2014/02/21
@@ -55,6 +65,8 @@
 
 //EpollServer* EpollServer::m_pInstance = NULL;
 
+__thread std::vector<struct zc_grave>* EpollServer::_graveyard = NULL;
+
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: Instance
 --
@@ -79,6 +91,50 @@ EpollServer* EpollServer::Instance()
 	return &m_pInstance;
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: reap
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void EpollServer::reap(std::vector<struct zc_grave>& graveyard)
+--                            std::vector<struct zc_grave>& graveyard - closed connections of the calling worker
+--
+-- RETURNS:  void
+--
+-- NOTES: Reads the zero-copy completions of each closed connection in the graveyard, and frees its buffers and
+-- closes its socket once none are pinned.  If the error queue cannot be read the buffers are given up on: they
+-- are forgotten rather than freed, since the kernel may still hold them.
+----------------------------------------------------------------------------------------------------------------------*/
+void EpollServer::reap(std::vector<struct zc_grave>& graveyard)
+{
+	for(size_t i = 0; i < graveyard.size();){
+		struct zc_grave& grave = graveyard[i];
+		int copied = 0;
+		int n = grave.out->complete_zerocopy(grave.fd, &copied);
+		if(n > 0){
+			ClientData::Instance()->recordZerocopyDone(n, copied);
+		}
+		if(n >= 0 && grave.out->pinned() > 0){
+			++i;
+			continue;
+		}
+		if(n < 0){
+			LOG_WARN("socket %d closed with %zu zero-copy sends unconfirmed", grave.fd, grave.out->pinned());
+			grave.out->clear();
+		}
+		close(grave.fd);
+		delete grave.out;
+		grave = graveyard.back();
+		graveyard.pop_back();
+	}
+}
+
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: run
 --
@@ -100,7 +156,7 @@ int EpollServer::run() {
 	pthread_t tids[_numThreads];
 	int i;
 
-	
+	ClientData::Instance()->setQueueProbe(queue_stats);
 	for(int i = 0; i < _numThreads; i++)
 	{
 		pthread_create(&tids[i], NULL, process_client, NULL);
@@ -111,6 +167,13 @@ int EpollServer::run() {
 	serverSock = create_socket();
 	serverSock = bind_socket();
 	serverSock = set_sock_option(serverSock);
+
+	// a socket without SO_ZEROCOPY ignores MSG_ZEROCOPY and never completes, so check the kernel has it
+	int value = 1;
+	if (_zerocopy > 0 && setsockopt (serverSock, SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)) == -1) {
+		perror("SO_ZEROCOPY not supported, sending with copies");
+		_zerocopy = 0;
+	}
 	
 
 	// Make the server listening socket non-blocking
@@ -123,44 +186,73 @@ int EpollServer::run() {
 	epoll_fd = epoll_create(MAXCLIENTS);
 	if (epoll_fd == -1) 
 		fprintf(stderr,"epoll_create\n");
-	// Add the server socket to the epoll event loop
-	event.events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET;
-	event.data.fd = serverSock;
-	if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, serverSock, &event) == -1) 
-		fprintf(stderr,"epoll_ctl\n");
+	if (_acceptThreads > 0) {
+		// the accept threads share the listen socket, each wakeup goes to one of them
+		pthread_t atids[_acceptThreads];
+		for(int i = 0; i < _acceptThreads; i++)
+		{
+			pthread_create(&atids[i], NULL, process_accept, NULL);
+		}
+	} else {
+		// Add the server socket to the epoll event loop.  It is level-triggered so a connection storm is
+		// accepted a batch per wakeup, in between client events, instead of all at once.
+		event.events = EPOLLIN | EPOLLERR | EPOLLHUP;
+		event.data.u64 = MAKE_TOKEN(serverSock, 0);
+		if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, serverSock, &event) == -1) 
+			fprintf(stderr,"epoll_ctl\n");
+	}
 	
+	Tracer* tracer = Tracer::Instance();
+	thread_stats* stats = ThreadStats::local();
+	uint64_t ready = 0, token, waited, now;
+	ThreadStats::set_role("dispatcher");
 	while(true){
 		nready = epoll_wait (epoll_fd, events, MAXCLIENTS, -1);
+		now = stat_now_ns();
+		ThreadStats::tick(now);
+		if(tracer->enabled()){
+			ready = now;
+		}
 		for (i = 0; i < nready; i++){	// check all clients for data
 
-		// Case 1: Error condition
-    		if (events[i].events & (EPOLLHUP)) {
-			fputs("epoll: EPOLLHUP", stderr);
-			int sock = events[i].data.fd;
-			close(sock);
-			ClientData::Instance()->removeClient(sock);
-			continue;
-    		}
-    		if (events[i].events & ( EPOLLERR)) {
-			fputs("epoll: EPOLLERR", stderr);
-			int sock = events[i].data.fd;
-			close(sock);
-			ClientData::Instance()->removeClient(sock);
-			continue;
-    		}
-	
-    		assert (events[i].events & EPOLLIN);
+			// Case 1: Server is receiving a connection request
+			if (events[i].data.u64 == MAKE_TOKEN(serverSock, 0)) {
 
-	    	// Case 2: Server is receiving a connection request
-	    	if (events[i].data.fd == serverSock) {
+				accept_clients();
+				continue;
+			}
 
-				while(accept_client()>1);
+			// client sockets are oneshot: this event disarmed the socket, so
+			// this thread owns it until it is queued or closed
+			int sock = TOKEN_FD(events[i].data.u64);
+
+			// Case 2: Error condition; with zero-copy on a worker closes it, in case it has sends pinned
+			if ((events[i].events & EPOLLHUP) && _zerocopy == 0) {
+				LOG_WARN("epoll: EPOLLHUP on socket %d", sock);
+				close_client(sock);
+				continue;
+			}
+			// zero-copy completions are reported as EPOLLERR, the worker tells them apart from real errors
+			if ((events[i].events & (EPOLLERR | EPOLLHUP)) && _zerocopy > 0) {
+				fd_queue.push(events[i].data.u64, timeout, &waited);
+				stats->push_wait.record(waited);
+				continue;
+			}
+			if (events[i].events & ( EPOLLERR)) {
+				LOG_WARN("epoll: EPOLLERR on socket %d", sock);
+				close_client(sock);
 				continue;
-    		}
+			}
 
-    		// Case 3: One of the sockets has read data
+			assert (events[i].events & (EPOLLIN | EPOLLOUT));
 
-			fd_queue.push(events[i].data.fd, timeout);
+			// Case 3: One of the sockets has read data or room to write, hand it to a worker
+			token = events[i].data.u64;
+			if(tracer->enabled() && tracer->sample()){
+				token = tracer->begin(token, ready);
+			}
+			fd_queue.push(token, timeout, &waited);
+			stats->push_wait.record(waited);
 
  		}
 	
@@ -253,56 +345,87 @@ void EpollServer::listen_for_clients()
 {
 	// Listen for connections
 	
-	listen(serverSock, SOMAXCONN);
+	listen(serverSock, _backlog);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
--- FUNCTION: accept_client
+-- FUNCTION: accept_clients
 --
 -- DATE: 2014/02/21
 --
--- REVISIONS: (Date and Description)
+-- REVISIONS: 2026/10/18 - accept a batch of connections with accept4
+--		2026/10/18 - sets TCP_NODELAY on each connection
+--		2026/10/18 - only counts connections that were added
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: int EpollServer::accept_client()
+-- INTERFACE: int EpollServer::accept_clients()
 --
--- RETURNS:  New Socket Descriptor
+-- RETURNS:  Number of connections accepted and added, -1 on error
 --
--- NOTES: Function that blocks until a client connection request comes in. It will add the client to the list.
+-- NOTES: Accepts up to ACCEPT_BATCH pending connections and adds them to the list.  A connection the list has
+-- no room for is closed, and takes up its place in the batch without being counted.  accept4 hands back sockets
+-- that are already non-blocking, and the batch is counted with a single update.  Each socket is registered
+-- oneshot under a new generation of its fd.  Safe to call from several accept threads at once.
 ----------------------------------------------------------------------------------------------------------------------*/
-int EpollServer::accept_client()
+int EpollServer::accept_clients()
 {
 	
 	struct	sockaddr_in client;
-	unsigned int client_len = sizeof(client);
-	int sServerSock;
-	if ((sServerSock = accept (serverSock, (struct sockaddr *)&client, &client_len)) == -1){
-		if (errno != EAGAIN && errno != EWOULDBLOCK) {
-			fprintf(stderr, "Can't accept client\n");
-			return -1;
-		} else {
-			return 0;
+	socklen_t client_len;
+	char client_addr[INET_ADDRSTRLEN];
+	int sServerSock, accepted = 0;
+	for (int tries = 0; tries < ACCEPT_BATCH; ++tries) {
+		client_len = sizeof(client);
+		if ((sServerSock = accept4 (serverSock, (struct sockaddr *)&client, &client_len, SOCK_NONBLOCK | SOCK_CLOEXEC)) == -1){
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				LOG_WARN("Can't accept client: %s", strerror(errno));
+				if (accepted == 0) {
+					return -1;
+				}
+			}
+			break;
+		}
+
+		// inet_ntoa's static buffer is not safe with several accept threads
+		inet_ntop(AF_INET, &client.sin_addr, client_addr, sizeof(client_addr));
+		if (ClientData::Instance()->addClient(sServerSock, client_addr, client.sin_port ) < 0) {
+			LOG_WARN("fd %d over limit", sServerSock);
+			close(sServerSock);
+			continue;
+		}
+		++accepted;
+		uint32_t gen = ClientData::Instance()->generation(sServerSock);
+
+		// echoes go out as soon as they are read, not held by Nagle until the client's delayed ACK
+		int nodelay = 1;
+		if (setsockopt (sServerSock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+			perror("setsockopt TCP_NODELAY");
+		}
+
+		int value = 1;
+		if (_zerocopy > 0 && setsockopt (sServerSock, SOL_SOCKET, SO_ZEROCOPY, &value, sizeof(value)) == -1) {
+			perror("setsockopt SO_ZEROCOPY");
+		}
+
+		// Add the new socket descriptor to the epoll loop
+		struct epoll_event clientEvent;
+		clientEvent.events = EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLET | EPOLLONESHOT;
+		clientEvent.data.u64 = MAKE_TOKEN(sServerSock, gen);
+		if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, sServerSock, &clientEvent) == -1) {
+			fprintf(stderr,"epoll_ctl\n");
 		}
-		
-	}
-	
-	// Make the fd_new non-blocking
-	if (fcntl (sServerSock, F_SETFL, O_NONBLOCK | fcntl(sServerSock, F_GETFL, 0)) == -1) {
-		fprintf(stderr,"fcntl\n");
 	}
-	// Add the new socket descriptor to the epoll loop
-	event.data.fd = sServerSock;
-	if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, sServerSock, &event) == -1) {
-		fprintf(stderr,"epoll_ctl\n");
+	if (accepted > 0) {
+		ClientData::Instance()->recordAccept(accepted);
 	}
-	
-	
-	ClientData::Instance()->addClient(sServerSock, inet_ntoa(client.sin_addr),client.sin_port );
 
-	return sServerSock;
+	return accepted;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -316,17 +439,22 @@ int EpollServer::accept_client()
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: void EpollServer::send_msgs(int socket, char * data)
+-- INTERFACE: int EpollServer::send_msgs(int socket, char * data, int len)
 --					  int socket - server sock
 --					  char * data - data that the server will send back to the client
+--					  int len - number of bytes to send
 --
--- RETURNS:  void
+-- RETURNS:  number of bytes left pending in the client's output buffer, -1 if the socket failed
 --
--- NOTES: Send Messages function used by the epoll server.
+-- NOTES: Send Messages function used by the epoll server.  Whatever the socket does not take right away is
+-- kept in the client's output buffer and sent when the socket reports EPOLLOUT.
 ----------------------------------------------------------------------------------------------------------------------*/
-void EpollServer::send_msgs(int socket, char * data)
+int EpollServer::send_msgs(int socket, char * data, int len)
 {
-	send(socket, data, _buflen, 0);
+	OutputBuffer* out = ClientData::Instance()->output(socket);
+	if (out == NULL)
+		return -1;
+	return out->write(socket, data, len);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -344,9 +472,9 @@ void EpollServer::send_msgs(int socket, char * data)
 --					 int socket - server socket
 --					 char * bp - data that the server will receive from the client
 --
--- RETURNS:  Socket Descriptor
+-- RETURNS:  number of bytes read, -1 if the client was closed
 --
--- NOTES: Send Messages function used by the epoll server.
+-- NOTES: Receive Messages function used by the epoll server.
 ----------------------------------------------------------------------------------------------------------------------*/
 int EpollServer::recv_msgs(int socket, char * bp)
 {
@@ -358,22 +486,93 @@ int EpollServer::recv_msgs(int socket, char * bp)
 			if (errno == EAGAIN || errno == EWOULDBLOCK) {
 				break;
 			}
-			printf("error %d %d %d\n", bytes_to_read, n, socket);
-			printf("error %d\n",errno);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
+			LOG_WARN("recv error %d on socket %d, %d bytes to read", errno, socket, bytes_to_read);
+			close_client(socket);
 			return -1;
 		} else if (n == 0){
-			printf("socket was gracefully closed by other side %d\n",socket);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
+			LOG_INFO("socket was gracefully closed by other side %d", socket);
+			close_client(socket);
 			return -1;
 		}
 		bp += n;
 		bytes_to_read -= n;
 	}
+	if(n > 0){
+		bytes_to_read -= n;
+	}
 
-	return 0;
+	return _buflen - bytes_to_read;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: splice_msgs
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::splice_msgs(int socket, int pipefd[2], char * bp)
+--					 int socket - client socket with no output pending
+--					 int pipefd[2] - the calling worker's empty non-blocking pipe
+--					 char * bp - scratch buffer of _buflen bytes
+--
+-- RETURNS:  number of bytes echoed, -1 if the client was closed
+--
+-- NOTES: Echo path that never copies the payload to user space: up to _buflen bytes are spliced from the
+-- socket into the pipe and from the pipe back to the socket.  If the socket cannot take all of it, the rest
+-- is read out of the pipe into the client's output buffer so the pipe is empty for the next client.
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::splice_msgs(int socket, int pipefd[2], char * bp)
+{
+	int n, m, left, total = 0;
+	while (total < _buflen)
+	{
+		n = splice(socket, NULL, pipefd[1], NULL, _buflen - total, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+		if(n == -1){
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			LOG_WARN("splice error %d on socket %d, %d bytes to read", errno, socket, _buflen - total);
+			close_client(socket);
+			return -1;
+		} else if (n == 0){
+			LOG_INFO("socket was gracefully closed by other side %d", socket);
+			close_client(socket);
+			return -1;
+		}
+		total += n;
+
+		for (left = n; left > 0; left -= m)
+		{
+			m = splice(pipefd[0], NULL, socket, NULL, left, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+			if(m == -1){
+				break;
+			}
+		}
+		if(left == 0){
+			continue;
+		}
+
+		// the socket is full or failed: empty the pipe into the output buffer
+		bool failed = (errno != EAGAIN && errno != EWOULDBLOCK);
+		while (left > 0 && (m = read(pipefd[0], bp, left < _buflen ? left : _buflen)) > 0)
+		{
+			left -= m;
+			if(!failed && send_msgs(socket, bp, m) < 0){
+				failed = true;
+			}
+		}
+		if(failed){
+			close_client(socket);
+			return -1;
+		}
+		break;
+	}
+	return total;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -413,6 +612,77 @@ int EpollServer::set_sock_option(int listenSocket)
 
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: arm_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::arm_client(uint64_t token)
+--					 uint64_t token - generation and fd of the connection
+--
+-- RETURNS:  0 on success, -1 if the socket could not be re-armed
+--
+-- NOTES: Gives up ownership of a connection by re-enabling its oneshot registration.  If data arrived while it
+-- was owned the kernel reports it again straight away.  EPOLLOUT is only asked for while output is pending,
+-- and EPOLLIN is left out while the output buffer is over its high watermark.
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::arm_client(uint64_t token)
+{
+	struct epoll_event clientEvent;
+	OutputBuffer* out = ClientData::Instance()->output(TOKEN_FD(token));
+	clientEvent.events = EPOLLERR | EPOLLHUP | EPOLLET | EPOLLONESHOT;
+	if (out == NULL || !out->paused())
+		clientEvent.events |= EPOLLIN;
+	if (out != NULL && out->pending() > 0)
+		clientEvent.events |= EPOLLOUT;
+	clientEvent.data.u64 = token;
+	if (epoll_ctl (epoll_fd, EPOLL_CTL_MOD, TOKEN_FD(token), &clientEvent) == -1) {
+		fprintf(stderr,"epoll_ctl\n");
+		return -1;
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: close_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::close_client(int socket)
+--					 int socket - client socket owned by the calling thread
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Removing the client retires the current generation of the socket before it is closed, so any queued
+-- entry for it is dropped even if the fd number is reused by the next accept.  A connection a worker closes
+-- with zero-copy sends still pinned goes to that worker's graveyard instead, socket open, until they complete.
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::close_client(int socket)
+{
+	OutputBuffer* out = _graveyard != NULL ? ClientData::Instance()->output(socket) : NULL;
+	if(out != NULL && out->pinned() > 0){
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, socket, NULL);
+		_graveyard->push_back(zc_grave{socket, ClientData::Instance()->detachOutput(socket)});
+		ClientData::Instance()->removeClient(socket);
+		return 0;
+	}
+	ClientData::Instance()->removeClient(socket);
+	close(socket);
+	return 0;
+}
+
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: process_client
 --
@@ -429,30 +699,188 @@ int EpollServer::set_sock_option(int listenSocket)
 -- RETURNS:  0 on success
 --
 -- NOTES: Thread that processes the client by receiving and sending packets from the server. 
+-- A popped connection is owned by this worker until it is re-armed, so no other worker can read it meanwhile.
+-- In splice mode each worker keeps one pipe for echoing; a client with output pending takes the copying path
+-- so its echoes stay in order.  In zero-copy mode a worker hands its receive buffer to the connection whenever
+-- it goes out with MSG_ZEROCOPY and takes a fresh one, and keeps the connections it closed with sends still
+-- pinned until they complete, checking them every REAP_INTERVAL_MS while there are any.  The time from a pop to the next one counts as busy.
+-- A request the dispatcher sampled for tracing gets its dequeue, recv and send stamps here.  How long each pop
+-- waited for work goes into the worker's pop wait histogram.
 ----------------------------------------------------------------------------------------------------------------------*/
 void * EpollServer::process_client(void * args)
 {	
-	int sock;
+	uint64_t token;
+	int sock, n;
+	OutputBuffer* out;
 
 	EpollServer* mServer = EpollServer::Instance();
 	char buf[mServer->_buflen];	
+	// zero-copy echoes are received into heap buffers, since a sent one stays pinned until its completion
+	char * zbuf = NULL;
+	bool pinned;
+	int copied;
+	std::vector<struct zc_grave> graveyard;
+	if(mServer->_zerocopy > 0 && (zbuf = (char *) malloc(mServer->_buflen)) == NULL){
+		LOG_ERROR("out of memory, sending with copies");
+	}
+	if(mServer->_zerocopy > 0){
+		_graveyard = &graveyard;
+	}
+	thread_stats* stats = ThreadStats::local();
+	uint64_t busy_since = 0, dequeued = 0, received = 0, waited;
+	ThreadStats::set_role("epoll_worker", true);
+	int pipefd[2] = {-1, -1};
+	if(mServer->_splice){
+		if(pipe2(pipefd, O_NONBLOCK) == -1){
+			perror("pipe2, using the copying echo");
+			pipefd[0] = pipefd[1] = -1;
+		} else if(fcntl(pipefd[1], F_GETPIPE_SZ) < mServer->_buflen){
+			fcntl(pipefd[1], F_SETPIPE_SZ, mServer->_buflen);
+		}
+	}
 	while(1){
-		mServer->fd_queue.pop(sock, mServer->timeout);
-		if(!ClientData::Instance()->has(sock)){
+		if(busy_since != 0){
+			stat_add(stats->busy_ns, stat_now_ns() - busy_since);
+			busy_since = 0;
+		}
+		if(!graveyard.empty()){
+			mServer->reap(graveyard);
+		}
+		if(!mServer->fd_queue.pop(token, graveyard.empty() ? mServer->timeout :
+			std::chrono::milliseconds(REAP_INTERVAL_MS), &waited)){
+			continue;
+		}
+		stats->pop_wait.record(waited);
+		busy_since = stat_now_ns();
+		ThreadStats::tick(busy_since);
+		// a sampled request: the dequeue is timed from here, the mark must not reach epoll
+		dequeued = received = 0;
+		if(token & TOKEN_TRACED_BIT){
+			token &= ~TOKEN_TRACED_BIT;
+			dequeued = busy_since;
+		}
+		sock = TOKEN_FD(token);
+		// stale entry for a connection that has since been closed
+		if(ClientData::Instance()->generation(sock) != TOKEN_GEN(token)){
 			continue;
 		}
+		out = ClientData::Instance()->output(sock);
 		
-		if(mServer->recv_msgs(sock, buf)<0){
+		// release the buffers of zero-copy sends the kernel is done with
+		if(out->pinned() > 0){
+			if((n = out->complete_zerocopy(sock, &copied)) < 0){
+				mServer->close_client(sock);
+				continue;
+			}
+			if(n > 0){
+				ClientData::Instance()->recordZerocopyDone(n, copied);
+			}
+		}
+		// push out anything a slow reader left behind first
+		if(out->pending() > 0 && out->flush(sock) < 0){
+			mServer->close_client(sock);
 			continue;
 		}
-		ClientData::Instance()->setRtt(sock);
-		mServer->send_msgs(sock, buf);	
-		ClientData::Instance()->recordData(sock, mServer->_buflen);
+		// leave the input alone while the client is backed up
+		if(!out->paused() && pipefd[0] >= 0 && out->pending() == 0){
+			if((n = mServer->splice_msgs(sock, pipefd, buf))<0){
+				continue;
+			}
+			received = dequeued != 0 ? stat_now_ns() : 0;
+			if(n > 0){
+				ClientData::Instance()->setRtt(sock);
+				ClientData::Instance()->recordData(sock, n);
+			}
+		} else if(!out->paused() && zbuf != NULL){
+			if((n = mServer->recv_msgs(sock, zbuf))<0){
+				continue;
+			}
+			received = dequeued != 0 ? stat_now_ns() : 0;
+			if(n > 0){
+				ClientData::Instance()->setRtt(sock);
+				pinned = false;
+				if(n >= mServer->_zerocopy){
+					n = out->write_zerocopy(sock, zbuf, n, &pinned) < 0 ? -1 : n;
+				} else {
+					n = mServer->send_msgs(sock, zbuf, n) < 0 ? -1 : n;
+				}
+				if(n < 0){
+					mServer->close_client(sock);
+					continue;
+				}
+				ClientData::Instance()->recordSend(pinned);
+				ClientData::Instance()->recordData(sock, n);
+				if(pinned && (zbuf = (char *) malloc(mServer->_buflen)) == NULL){
+					LOG_ERROR("out of memory, sending with copies");
+				}
+			}
+		} else if(!out->paused()){
+			if((n = mServer->recv_msgs(sock, buf))<0){
+				continue;
+			}
+			received = dequeued != 0 ? stat_now_ns() : 0;
+			if(n > 0){
+				ClientData::Instance()->setRtt(sock);
+				if(mServer->send_msgs(sock, buf, n) < 0){
+					mServer->close_client(sock);
+					continue;
+				}
+				ClientData::Instance()->recordData(sock, n);
+			}
+		}
+		if(dequeued != 0){
+			Tracer::Instance()->end(token, dequeued, received, stat_now_ns());
+		}
+		mServer->arm_client(token);
 	}		            				
 	return (void*)0;
 
 }
 
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_accept
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * EpollServer::process_accept(void * args)
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Accept thread.  Every accept thread watches the listen socket from its own epoll instance with
+-- EPOLLEXCLUSIVE, so a new connection wakes one of them rather than all, and accepts a batch per wakeup.
+-- New connections go on the dispatcher's epoll instance.
+----------------------------------------------------------------------------------------------------------------------*/
+void * EpollServer::process_accept(void * args)
+{
+	EpollServer* mServer = EpollServer::Instance();
+	struct epoll_event acceptEvent;
+	int accept_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (accept_fd == -1) {
+		perror("epoll_create1");
+		exit(1);
+	}
+	acceptEvent.events = EPOLLIN | EPOLLEXCLUSIVE;
+	acceptEvent.data.u64 = MAKE_TOKEN(mServer->serverSock, 0);
+	if (epoll_ctl (accept_fd, EPOLL_CTL_ADD, mServer->serverSock, &acceptEvent) == -1) {
+		perror("epoll_ctl EPOLLEXCLUSIVE");
+		exit(1);
+	}
+	ThreadStats::set_role("acceptor");
+	while(1){
+		if (epoll_wait (accept_fd, &acceptEvent, 1, -1) > 0) {
+			ThreadStats::tick(stat_now_ns());
+			mServer->accept_clients();
+		}
+	}
+	return (void*)0;
+}
+
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: set_port
 --
@@ -519,3 +947,118 @@ int EpollServer::setBufLen(int buflen){
 	_buflen = buflen;
 	return 1;
 }
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_splice
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::set_splice(bool on)
+--					bool on - echo with splice() instead of recv/send
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Turns the zero-copy echo path on or off.  Call before run().
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::set_splice(bool on){
+	_splice = on;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_zerocopy
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::set_zerocopy(int threshold)
+--					int threshold - smallest echo sent with MSG_ZEROCOPY, 0 turns zero-copy off
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Pinning pages and reading the completion costs more than copying a small payload, so only echoes of
+-- at least the threshold go out zero-copy.  Call before run().
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::set_zerocopy(int threshold){
+	_zerocopy = threshold;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_backlog
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::set_backlog(int backlog)
+--					int backlog - length of the listen queue
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets how many pending connections the listen socket queues.  The kernel caps it at somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::set_backlog(int backlog){
+	_backlog = backlog;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_accept_threads
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int EpollServer::set_accept_threads(int num)
+--					int num - number of accept threads, 0 to accept on the dispatcher thread
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Moves accepting off the dispatcher thread so a connection storm does not hold up client events.
+----------------------------------------------------------------------------------------------------------------------*/
+int EpollServer::set_accept_threads(int num){
+	_acceptThreads = num;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: queue_stats
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void EpollServer::queue_stats(stats_snapshot& snap, bool reset)
+--					stats_snapshot& snap - gets the depth, high water mark and push timeouts of fd_queue
+--					bool reset           - start the high water mark over
+--
+-- RETURNS:  void
+--
+-- NOTES: Probe given to ClientData for the stats.  Reads the queue's counters without a lock, so the numbers
+-- may already be stale.
+----------------------------------------------------------------------------------------------------------------------*/
+void EpollServer::queue_stats(stats_snapshot& snap, bool reset){
+	EpollServer* mServer = EpollServer::Instance();
+	snap.queue_depth = (long) mServer->fd_queue.size();
+	snap.queue_high_water = (long) mServer->fd_queue.high_water(reset);
+	snap.push_timeouts = mServer->fd_queue.push_timeouts();
+}
@@ -2,7 +2,9 @@
 #define EPOLL_SERVER_H
 
 #include "client_data.h"
-#include "blocking_queue.h"
+#include "mpmc_queue.h"
+#include "output_buffer.h"
+#include "tracer.h"
 
 #include <atomic>
 #include <iostream>
@@ -23,13 +25,30 @@
 #include <sys/epoll.h>
 #include <assert.h>
 #include <fcntl.h>
+#include <stdint.h>
 
 
 #define BUFLEN 255
 #define TCP_PORT 7000
 #define MAXCLIENTS 100000
-
-
+#define ACCEPT_BATCH 64		// connections accepted per wakeup before going back to epoll_wait
+#define REAP_INTERVAL_MS 10		// how often a worker with closed connections still pinning buffers checks them
+
+// a queued connection is (ClientData generation << 32 | fd) so stale entries can be told apart from a reused fd;
+// bit 31 is left for the tracer's mark
+#define MAKE_TOKEN(fd, gen) (((uint64_t)(gen) << 32) | (uint32_t)(fd))
+#define TOKEN_FD(token) ((int)((token) & 0x7fffffff))
+#define TOKEN_GEN(token) ((uint32_t)((token) >> 32))
+
+/**
+a closed connection that still had MSG_ZEROCOPY sends in flight.  its socket
+stays open, out of the client table, so the kernel can report the sends done
+on the error queue; the buffers are freed and the socket closed after that.
+*/
+struct zc_grave {
+	int fd;
+	OutputBuffer* out;
+};
 
 
 class EpollServer {
@@ -43,21 +62,35 @@ public:
 	int create_socket();
 	int bind_socket();
 	void listen_for_clients();
-	int accept_client();
-	void send_msgs(int socket, char * data);
+	int accept_clients();
+	int send_msgs(int socket, char * data, int len);
 	int recv_msgs(int socket, char * bp);
+	int splice_msgs(int socket, int pipefd[2], char * bp);
 	int set_sock_option(int listenSocket);
+	int arm_client(uint64_t token);
+	int close_client(int socket);
 	int set_port(int port);
 	int set_num_threads(int num);
 	int setBufLen(int buflen);
+	int set_backlog(int backlog);
+	int set_accept_threads(int num);
+	int set_splice(bool on);
+	int set_zerocopy(int threshold);
+	static void queue_stats(stats_snapshot& snap, bool reset);
 	int _buflen;
+	bool _splice;
+	int _zerocopy;	// echoes of at least this many bytes go out with MSG_ZEROCOPY, 0 = never
 private:
 
-	int 	serverSock, _port, _numThreads;
+	int 	serverSock, _port, _backlog, _numThreads, _acceptThreads;
 	static void * process_client(void * args);
+	static void * process_accept(void * args);
+	void reap(std::vector<struct zc_grave>& graveyard);
+
+	static __thread std::vector<struct zc_grave>* _graveyard;	// the calling worker's, NULL for other threads
 
 	
-	blocking_queue<int> fd_queue;
+	mpmc_queue<uint64_t> fd_queue;
 	
 	int epoll_fd;
 	int maxfd;
@@ -0,0 +1,286 @@
+#include "histogram.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: histogram.cpp - Hold the code for the latency histograms kept by the servers.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: Histogram::Histogram()
+--			  void Histogram::add_to(HistogramSnapshot& snap) const
+--			  uint64_t Histogram::highest(int bucket)
+--			  HistogramSnapshot::HistogramSnapshot()
+--			  void HistogramSnapshot::clear()
+--			  void HistogramSnapshot::add(const HistogramSnapshot& other)
+--			  void HistogramSnapshot::add(int bucket, uint64_t count)
+--			  void HistogramSnapshot::subtract(const HistogramSnapshot& older)
+--			  uint64_t HistogramSnapshot::percentile(double p) const
+--			  uint64_t HistogramSnapshot::max() const
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: A histogram is written by one thread and read by the stats thread.  Counts are cumulative; the stats
+-- thread gets the counts of an interval by subtracting the snapshot it took at the end of the previous one.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Histogram (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Histogram::Histogram()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Creates an empty histogram.
+----------------------------------------------------------------------------------------------------------------------*/
+Histogram::Histogram() : _shared(false){
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		_counts[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: add_to
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Histogram::add_to(HistogramSnapshot& snap) const
+--				HistogramSnapshot& snap - snapshot the counts are added to
+--
+-- RETURNS:  void
+--
+-- NOTES: Adds the current counts to a snapshot.  Safe while the owner records; a record that races with the
+-- copy shows up in the next interval.
+----------------------------------------------------------------------------------------------------------------------*/
+void Histogram::add_to(HistogramSnapshot& snap) const{
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		uint64_t c = _counts[i].load(std::memory_order_relaxed);
+		snap._counts[i] += c;
+		snap._total += c;
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: highest
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Histogram::highest(int bucket)
+--				int bucket - bucket index
+--
+-- RETURNS:  the largest value that is counted in the bucket
+--
+-- NOTES: Percentiles are reported as the top of their bucket, so they are never understated.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Histogram::highest(int bucket){
+	if(bucket < HIST_SUB_COUNT){
+		return bucket;
+	}
+	int k = bucket - HIST_SUB_COUNT;
+	int shift = k / HIST_HALF_COUNT + 1;
+	uint64_t top = k % HIST_HALF_COUNT + HIST_HALF_COUNT;
+	return ((top + 1) << shift) - 1;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: HistogramSnapshot (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: HistogramSnapshot::HistogramSnapshot()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Creates an empty snapshot.
+----------------------------------------------------------------------------------------------------------------------*/
+HistogramSnapshot::HistogramSnapshot(){
+	clear();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: clear
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void HistogramSnapshot::clear()
+--
+-- RETURNS:  void
+--
+-- NOTES: Empties the snapshot.
+----------------------------------------------------------------------------------------------------------------------*/
+void HistogramSnapshot::clear(){
+	memset(_counts, 0, sizeof(_counts));
+	_total = 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: add
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void HistogramSnapshot::add(const HistogramSnapshot& other)
+--				const HistogramSnapshot& other - counts to add
+--
+-- RETURNS:  void
+--
+-- NOTES: Merges another snapshot into this one.
+----------------------------------------------------------------------------------------------------------------------*/
+void HistogramSnapshot::add(const HistogramSnapshot& other){
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		_counts[i] += other._counts[i];
+	}
+	_total += other._total;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: add
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void HistogramSnapshot::add(int bucket, uint64_t count)
+--				int bucket     - bucket index
+--				uint64_t count - values to add to it
+--
+-- RETURNS:  void
+--
+-- NOTES: For rebuilding a snapshot from counts kept elsewhere, such as the shared memory segment.
+----------------------------------------------------------------------------------------------------------------------*/
+void HistogramSnapshot::add(int bucket, uint64_t count){
+	_counts[bucket] += count;
+	_total += count;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: subtract
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void HistogramSnapshot::subtract(const HistogramSnapshot& older)
+--				const HistogramSnapshot& older - earlier snapshot of the same histograms
+--
+-- RETURNS:  void
+--
+-- NOTES: Leaves only what was recorded since the older snapshot.
+----------------------------------------------------------------------------------------------------------------------*/
+void HistogramSnapshot::subtract(const HistogramSnapshot& older){
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		_counts[i] -= older._counts[i];
+	}
+	_total -= older._total;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: percentile
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t HistogramSnapshot::percentile(double p) const
+--				double p - percentile, 0 to 100
+--
+-- RETURNS:  the value at or below which p percent of the recorded values lie, 0 if the snapshot is empty
+--
+-- NOTES: Accurate to the width of one bucket.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t HistogramSnapshot::percentile(double p) const{
+	if(_total == 0){
+		return 0;
+	}
+	uint64_t rank = (uint64_t)(p / 100.0 * _total + 0.5);
+	if(rank < 1){
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		seen += _counts[i];
+		if(seen >= rank){
+			return Histogram::highest(i);
+		}
+	}
+	return max();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: max
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t HistogramSnapshot::max() const
+--
+-- RETURNS:  the top of the highest non-empty bucket, 0 if the snapshot is empty
+--
+-- NOTES: Taken from the buckets, so the maximum of an interval comes out of the difference of two snapshots.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t HistogramSnapshot::max() const{
+	for(int i = HIST_BUCKETS - 1; i >= 0; i--){
+		if(_counts[i] != 0){
+			return Histogram::highest(i);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,82 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+// log-linear buckets: values below HIST_SUB_COUNT get a bucket each, above that every power of two is split
+// into HIST_HALF_COUNT buckets, so a bucket is never wider than 1/16 of the values in it
+#define HIST_SUB_BITS 5
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT (HIST_SUB_COUNT / 2)
+#define HIST_MAX_BITS 40		// larger values are clamped (2^40 us is about 12 days)
+#define HIST_BUCKETS (HIST_SUB_COUNT + (HIST_MAX_BITS - HIST_SUB_BITS) * HIST_HALF_COUNT)
+
+/**
+plain copy of one or more histograms, used by the stats thread to merge the
+per-thread histograms and to take the difference between two intervals.
+*/
+class HistogramSnapshot {
+
+public:
+	HistogramSnapshot();
+
+	void clear();
+	void add(const HistogramSnapshot& other);
+	void add(int bucket, uint64_t count);
+	void subtract(const HistogramSnapshot& older);
+	uint64_t total() const { return _total; }
+	uint64_t percentile(double p) const;
+	uint64_t max() const;
+	uint64_t count(int bucket) const { return _counts[bucket]; }
+private:
+	friend class Histogram;
+
+	uint64_t _counts[HIST_BUCKETS];
+	uint64_t _total;
+};
+
+/**
+fixed size HDR style histogram with a single writer.  record() is a relaxed
+load and store on one bucket, with no lock, read-modify-write or allocation,
+so the stats thread can copy it at any time while the owner keeps recording.
+a histogram several threads write to is marked shared, and record() adds
+with fetch_add instead.
+*/
+class Histogram {
+
+public:
+	Histogram();
+	Histogram(const Histogram&) = delete;
+	Histogram& operator=(const Histogram&) = delete;
+
+	void record(uint64_t value){
+		std::atomic<uint64_t>& c = _counts[index(value)];
+		if(_shared){
+			c.fetch_add(1, std::memory_order_relaxed);
+		} else {
+			c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+	}
+	void set_shared() { _shared = true; }
+	void add_to(HistogramSnapshot& snap) const;
+
+	static int index(uint64_t value){
+		if(value < HIST_SUB_COUNT){
+			return (int) value;
+		}
+		if(value >> HIST_MAX_BITS){
+			value = (1ULL << HIST_MAX_BITS) - 1;
+		}
+		int msb = 63 - __builtin_clzll(value);
+		int shift = msb - HIST_SUB_BITS + 1;
+		return HIST_SUB_COUNT + (msb - HIST_SUB_BITS) * HIST_HALF_COUNT + (int)(value >> shift) - HIST_HALF_COUNT;
+	}
+	static uint64_t highest(int bucket);
+private:
+	std::atomic<uint64_t> _counts[HIST_BUCKETS];
+	bool _shared;		// written by more than one thread, set before any of them records
+};
+
+#endif
@@ -0,0 +1,636 @@
+#include "logger.h"
+#include <algorithm>
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: logger.cpp - Hold the code for the asynchronous logger.
+--
+-- PROGRAM: server, client
+--
+-- FUNCTIONS: static bool by_time(const struct log_record& a, const struct log_record& b)
+--			  Logger::Logger()
+--			  Logger* Logger::Instance()
+--			  struct log_record* Logger::begin(int level, const char* fmt)
+--			  void Logger::commit()
+--			  uint64_t Logger::word(struct log_record& r, const char* s)
+--			  struct log_ring* Logger::ring()
+--			  void Logger::release(void * ring)
+--			  bool Logger::flush(bool wait)
+--			  void Logger::drain(struct log_ring* r, int id)
+--			  void Logger::format(const struct log_record& r, std::string& out)
+--			  void Logger::write_all(FILE* f, std::string& out)
+--			  uint64_t Logger::dropped()
+--			  uint64_t Logger::suppressed()
+--			  void * Logger::process_log(void * args)
+--			  void Logger::flush_at_exit()
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Workers never format, lock or write: a log call fills a fixed size record in the thread's own ring.
+-- The writer thread formats whatever has collected every 10ms, ordered by time, and hands it to stdio in one
+-- write per stream.  A thread that logs faster than LOG_RATE, or fills its ring, loses records; the losses are
+-- counted and reported on stderr by the writer.
+----------------------------------------------------------------------------------------------------------------------*/
+
+std::atomic<int> Logger::_level(LOG_LEVEL_INFO);
+__thread struct log_ring* Logger::_local = NULL;
+
+static const char* level_names[] = {"debug: ", "", "warning: ", "error: "};
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: by_time
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static bool by_time(const struct log_record& a, const struct log_record& b)
+--
+-- RETURNS:  true if a was logged before b
+--
+-- NOTES: Orders a batch gathered from several rings.
+----------------------------------------------------------------------------------------------------------------------*/
+static bool by_time(const struct log_record& a, const struct log_record& b)
+{
+	return a.when_ns < b.when_ns;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Logger (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Logger::Logger()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Starts the writer thread and has whatever is still in the rings written at exit.  If the thread can't
+-- be started, records are only written by the flush at exit.
+----------------------------------------------------------------------------------------------------------------------*/
+Logger::Logger() : _count(0), _unringed(0), _reportedUnringed(0)
+{
+	if(pthread_key_create(&_key, release) != 0){
+		fprintf(stderr, "pthread_key_create\n");
+	}
+	pthread_mutex_init(&_lock, NULL);
+	pthread_mutex_init(&_flushLock, NULL);
+	_batch.reserve(LOG_RING);
+	atexit(flush_at_exit);
+	if(pthread_create(&tid, NULL, process_log, this) != 0){
+		fprintf(stderr, "Can't start the log writer\n");
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Logger* Logger::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates the instance of the logger the first time something is logged.  It is never destroyed: the
+-- writer thread and the flush at exit keep using it after static objects are gone.
+----------------------------------------------------------------------------------------------------------------------*/
+Logger* Logger::Instance()
+{
+	static Logger* m_pInstance = new Logger();
+
+	return m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: begin
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: struct log_record* Logger::begin(int level, const char* fmt)
+--					int level       - LOG_LEVEL_ of the record
+--					const char* fmt - printf style format, must be a string literal
+--
+-- RETURNS:  the record to fill in, NULL if the record is rate limited or the ring is full
+--
+-- NOTES: The rate limit is a token bucket of LOG_RATE records per second kept by the thread itself.  The record
+-- only becomes visible to the writer on commit().
+----------------------------------------------------------------------------------------------------------------------*/
+struct log_record* Logger::begin(int level, const char* fmt){
+	struct log_ring* r = ring();
+	if(r == NULL){
+		_unringed.fetch_add(1, std::memory_order_relaxed);
+		return NULL;
+	}
+	uint64_t now = stat_now_ns();
+	r->tokens += (now - r->refilled_ns) * (LOG_RATE / 1e9);
+	if(r->tokens > LOG_RATE){
+		r->tokens = LOG_RATE;
+	}
+	r->refilled_ns = now;
+	if(r->tokens < 1){
+		r->suppressed.store(r->suppressed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+	r->tokens -= 1;
+
+	uint64_t head = r->head.load(std::memory_order_relaxed);
+	if(head - r->tail.load(std::memory_order_acquire) >= LOG_RING){
+		r->dropped.store(r->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return NULL;
+	}
+	struct log_record* rec = &r->records[head % LOG_RING];
+	rec->when_ns = now;
+	rec->fmt = fmt;
+	rec->level = level;
+	rec->nargs = 0;
+	rec->text_used = 0;
+	return rec;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: commit
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::commit()
+--
+-- RETURNS:  void
+--
+-- NOTES: Hands the record begin() returned to the writer.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::commit(){
+	_local->head.store(_local->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: word
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Logger::word(struct log_record& r, const char* s)
+--					struct log_record& r - record being filled
+--					const char* s        - string argument
+--
+-- RETURNS:  offset of the copy in the record's text, LOG_NO_TEXT if there was no room left
+--
+-- NOTES: Strings can't be kept by pointer, they may be gone by the time the writer gets to them.  A string
+-- longer than the room left is cut short.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Logger::word(struct log_record& r, const char* s){
+	int room = LOG_TEXT - r.text_used;
+	if(room <= 1){
+		return LOG_NO_TEXT;
+	}
+	if(s == NULL){
+		s = "(null)";
+	}
+	uint64_t offset = r.text_used;
+	int n = strnlen(s, room - 1);
+	memcpy(r.text + offset, s, n);
+	r.text[offset + n] = '\0';
+	r.text_used += n + 1;
+	return offset;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: struct log_ring* Logger::ring()
+--
+-- RETURNS:  the calling thread's ring, NULL if there is no room for another
+--
+-- NOTES: A thread gets its ring the first time it logs: the ring of a thread that has exited, once the writer
+-- has drained it, or else a new one.  Rings are never freed, so the writer can always drain them.  The ring
+-- starts with a full bucket.
+----------------------------------------------------------------------------------------------------------------------*/
+struct log_ring* Logger::ring(){
+	if(_local != NULL){
+		return _local;
+	}
+	struct log_ring* r = NULL;
+	pthread_mutex_lock(&_lock);
+	int n = _count.load(std::memory_order_relaxed);
+	for(int i = 0; i < n && r == NULL; i++){
+		if(_rings[i]->exited.load(std::memory_order_acquire) &&
+			_rings[i]->tail.load(std::memory_order_acquire) == _rings[i]->head.load(std::memory_order_relaxed)){
+			r = _rings[i];
+		}
+	}
+	void* mem;
+	if(r == NULL && n < LOG_MAX_THREADS && posix_memalign(&mem, CACHE_LINE, sizeof(struct log_ring)) == 0){
+		r = new (mem) log_ring();
+		_rings[n] = r;
+		_count.store(n + 1, std::memory_order_release);
+	}
+	if(r != NULL){
+		r->exited.store(false, std::memory_order_relaxed);
+		r->tokens = LOG_RATE;
+		r->refilled_ns = stat_now_ns();
+		_local = r;
+		pthread_setspecific(_key, r);
+	}
+	pthread_mutex_unlock(&_lock);
+	return _local;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: release
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::release(void * ring)
+--				void * ring - ring of the exiting thread
+--
+-- RETURNS:  void
+--
+-- NOTES: Thread exit destructor.  Marks the ring free; ring() hands it out again once the writer has drained
+-- what the thread left in it.  Should the thread log again on the way out, it takes a ring afresh.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::release(void * ring){
+	_local = NULL;
+	((struct log_ring*) ring)->exited.store(true, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: flush
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: bool Logger::flush(bool wait)
+--					bool wait - wait for a drain already going on, instead of giving up
+--
+-- RETURNS:  false if another drain was going on and wait was false, true otherwise
+--
+-- NOTES: Drains every ring and writes what was in them.  Records are ordered by time within the batch; one
+-- logged while the batch was gathered can come out in the next one.
+----------------------------------------------------------------------------------------------------------------------*/
+bool Logger::flush(bool wait){
+	if(wait){
+		pthread_mutex_lock(&_flushLock);
+	} else if(pthread_mutex_trylock(&_flushLock) != 0){
+		return false;
+	}
+	int n = _count.load(std::memory_order_acquire);
+	for(int i = 0; i < n; i++){
+		drain(_rings[i], i);
+	}
+	uint64_t unringed = _unringed.load(std::memory_order_relaxed);
+	if(unringed != _reportedUnringed){
+		char line[128];
+		snprintf(line, sizeof(line), "log: lost %lu records of threads that found no free ring\n",
+			(unsigned long)(unringed - _reportedUnringed));
+		_err += line;
+		_reportedUnringed = unringed;
+	}
+	std::stable_sort(_batch.begin(), _batch.end(), by_time);
+	for(size_t i = 0; i < _batch.size(); i++){
+		format(_batch[i], _batch[i].level >= LOG_LEVEL_WARN ? _err : _out);
+	}
+	_batch.clear();
+	write_all(stdout, _out);
+	write_all(stderr, _err);
+	pthread_mutex_unlock(&_flushLock);
+	return true;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: drain
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::drain(struct log_ring* r, int id)
+--					struct log_ring* r - ring to empty
+--					int id             - its index, for the loss report
+--
+-- RETURNS:  void
+--
+-- NOTES: Copies the committed records into the batch and frees their slots.  Losses since the last drain are
+-- reported once per ring.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::drain(struct log_ring* r, int id){
+	char line[128];
+	uint64_t tail = r->tail.load(std::memory_order_relaxed);
+	uint64_t head = r->head.load(std::memory_order_acquire);
+	for(; tail < head; tail++){
+		_batch.push_back(r->records[tail % LOG_RING]);
+	}
+	r->tail.store(tail, std::memory_order_release);
+
+	uint64_t dropped = r->dropped.load(std::memory_order_relaxed);
+	uint64_t suppressed = r->suppressed.load(std::memory_order_relaxed);
+	if(dropped != r->reported_dropped || suppressed != r->reported_suppressed){
+		snprintf(line, sizeof(line), "log: thread %d lost %lu records to a full ring, %lu to the rate limit\n", id,
+			(unsigned long)(dropped - r->reported_dropped), (unsigned long)(suppressed - r->reported_suppressed));
+		_err += line;
+		r->reported_dropped = dropped;
+		r->reported_suppressed = suppressed;
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: format
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::format(const struct log_record& r, std::string& out)
+--					const struct log_record& r - record to format
+--					std::string& out           - receives the line
+--
+-- RETURNS:  void
+--
+-- NOTES: Walks the format and prints each conversion on its own, casting the argument word back to the type the
+-- conversion names.  Width, precision and flags are kept; length modifiers only decide the cast.  A conversion
+-- without an argument is copied as is.  Every record ends up on a line of its own.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::format(const struct log_record& r, std::string& out){
+	char spec[32], buf[256];
+	int arg = 0;
+	out += level_names[r.level];
+	for(const char* p = r.fmt; *p != '\0'; p++){
+		if(*p != '%'){
+			out += *p;
+			continue;
+		}
+		if(p[1] == '%'){
+			out += '%';
+			p++;
+			continue;
+		}
+		// %[flags][width][.precision][length]conversion
+		const char* start = p++;
+		int longs = 0;
+		while(*p != '\0' && strchr("-+ #0123456789.", *p) != NULL){
+			p++;
+		}
+		size_t len = p - start;
+		while(*p != '\0' && strchr("hlLqjzt", *p) != NULL){
+			longs += (*p != 'h');
+			p++;
+		}
+		if(*p == '\0' || arg >= r.nargs || len + 4 > sizeof(spec)){
+			out.append(start, p - start);
+			if(*p == '\0'){
+				break;
+			}
+			out += *p;
+			continue;
+		}
+		memcpy(spec, start, len);
+		uint64_t w = r.args[arg++];
+		int n = 0;
+		switch(*p){
+			case 'd': case 'i':
+				strcpy(spec + len, "ll");
+				spec[len + 2] = *p;
+				spec[len + 3] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, longs > 0 ? (long long)(int64_t) w : (long long)(int32_t) w);
+				break;
+			case 'u': case 'x': case 'X': case 'o':
+				strcpy(spec + len, "ll");
+				spec[len + 2] = *p;
+				spec[len + 3] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, longs > 0 ? (unsigned long long) w : (unsigned long long)(uint32_t) w);
+				break;
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A': {
+				double d;
+				memcpy(&d, &w, sizeof(d));
+				spec[len] = *p;
+				spec[len + 1] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, d);
+				break;
+			}
+			case 'c':
+				spec[len] = 'c';
+				spec[len + 1] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, (int) w);
+				break;
+			case 's':
+				spec[len] = 's';
+				spec[len + 1] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, w < LOG_TEXT ? r.text + w : "?");
+				break;
+			case 'p':
+				spec[len] = 'p';
+				spec[len + 1] = '\0';
+				n = snprintf(buf, sizeof(buf), spec, (void*)(uintptr_t) w);
+				break;
+			default:
+				out.append(start, p - start + 1);
+				arg--;
+				continue;
+		}
+		if(n > 0){
+			out.append(buf, n < (int) sizeof(buf) ? n : sizeof(buf) - 1);
+		}
+	}
+	if(out.empty() || out[out.size() - 1] != '\n'){
+		out += '\n';
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: write_all
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::write_all(FILE* f, std::string& out)
+--					FILE* f          - stream to write to
+--					std::string& out - formatted batch, emptied
+--
+-- RETURNS:  void
+--
+-- NOTES: Goes through stdio rather than the descriptor so the batch can't land in the middle of a line the
+-- stats thread has buffered on the same stream.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::write_all(FILE* f, std::string& out){
+	if(out.empty()){
+		return;
+	}
+	fwrite(out.data(), 1, out.size(), f);
+	fflush(f);
+	out.clear();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: dropped
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Logger::dropped()
+--
+-- RETURNS:  records lost to full rings since the start
+--
+-- NOTES: Sums the per thread counters, and the records of threads that had no ring to log to.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Logger::dropped(){
+	uint64_t total = _unringed.load(std::memory_order_relaxed);
+	int n = _count.load(std::memory_order_acquire);
+	for(int i = 0; i < n; i++){
+		total += _rings[i]->dropped.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: suppressed
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Logger::suppressed()
+--
+-- RETURNS:  records held back by the rate limit since the start
+--
+-- NOTES: Sums the per thread counters.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Logger::suppressed(){
+	uint64_t total = 0;
+	int n = _count.load(std::memory_order_acquire);
+	for(int i = 0; i < n; i++){
+		total += _rings[i]->suppressed.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_log
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * Logger::process_log(void * args)
+--					void * args - the logger
+--
+-- RETURNS:  never returns
+--
+-- NOTES: The writer thread.  Sleeps LOG_FLUSH_NS between drains, so a ring has to take LOG_RING records within
+-- one interval to overflow.
+----------------------------------------------------------------------------------------------------------------------*/
+void * Logger::process_log(void * args){
+	Logger* logger = (Logger*) args;
+	const struct timespec interval {0, LOG_FLUSH_NS};
+	ThreadStats::set_role("logger");
+	while(true){
+		nanosleep(&interval, NULL);
+		logger->flush();
+		ThreadStats::tick(stat_now_ns());
+	}
+	return NULL;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: flush_at_exit
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Logger::flush_at_exit()
+--
+-- RETURNS:  void
+--
+-- NOTES: Registered with atexit.  The servers exit from a signal handler, which may have interrupted the writer
+-- in the middle of a drain; rather than wait on it forever, this gives up after a short while.
+----------------------------------------------------------------------------------------------------------------------*/
+void Logger::flush_at_exit(){
+	const struct timespec pause {0, 1000000};
+	for(int i = 0; i < 100 && !Instance()->flush(false); i++){
+		nanosleep(&pause, NULL);
+	}
+}
@@ -0,0 +1,136 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include "thread_stats.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_ERROR 3		// warnings and errors go to stderr, the rest to stdout
+
+#define LOG_RING 1024			// records a thread can have waiting for the writer, more are dropped
+#define LOG_MAX_ARGS 6
+#define LOG_TEXT 56				// bytes of a record for copies of string arguments
+#define LOG_RATE 1000			// records per second a thread may log, in bursts of up to as many
+#define LOG_FLUSH_NS 10000000	// the writer drains the rings every 10ms
+#define LOG_MAX_THREADS 1024
+#define LOG_NO_TEXT (~0ULL)		// string argument that did not fit
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+// the arguments are only evaluated when the level is logged
+#define LOG_DEBUG(...) do { if(Logger::level() <= LOG_LEVEL_DEBUG) Logger::Instance()->log(LOG_LEVEL_DEBUG, __VA_ARGS__); } while(0)
+#define LOG_INFO(...) do { if(Logger::level() <= LOG_LEVEL_INFO) Logger::Instance()->log(LOG_LEVEL_INFO, __VA_ARGS__); } while(0)
+#define LOG_WARN(...) do { if(Logger::level() <= LOG_LEVEL_WARN) Logger::Instance()->log(LOG_LEVEL_WARN, __VA_ARGS__); } while(0)
+#define LOG_ERROR(...) do { if(Logger::level() <= LOG_LEVEL_ERROR) Logger::Instance()->log(LOG_LEVEL_ERROR, __VA_ARGS__); } while(0)
+
+/**
+one log call, formatted later by the writer thread.  fmt must be a string
+literal; numbers are kept as 64 bit words and strings are copied into text,
+with their offset as the word.
+*/
+struct log_record {
+	uint64_t when_ns;
+	const char* fmt;
+	uint8_t level;
+	uint8_t nargs;
+	uint8_t text_used;
+	uint64_t args[LOG_MAX_ARGS];
+	char text[LOG_TEXT];
+};
+
+/**
+single producer, single consumer ring of one thread.  the owner only
+touches head and its own counters; the writer only moves tail.  once its
+thread has exited and the writer has caught up, the ring goes to the next
+thread that logs, counters and all.
+*/
+struct log_ring {
+	std::atomic<uint64_t> head;
+	std::atomic<bool> exited;			// the owner is gone, the ring is free once drained
+	std::atomic<uint64_t> dropped;		// records lost because the ring was full
+	std::atomic<uint64_t> suppressed;	// records held back by the rate limit
+	double tokens;						// rate limit, owner only
+	uint64_t refilled_ns;
+	alignas(CACHE_LINE) std::atomic<uint64_t> tail;
+	uint64_t reported_dropped, reported_suppressed;		// writer only
+	struct log_record records[LOG_RING];
+};
+
+/**
+asynchronous logger.  a log call costs a clock read and a copy into the
+calling thread's ring, with no lock and no system call; a background thread
+formats the records and writes them out in batches.
+*/
+class Logger {
+
+public:
+	static Logger* Instance();
+	static int level() { return _level.load(std::memory_order_relaxed); }
+	static void set_level(int level) { _level.store(level, std::memory_order_relaxed); }
+
+	template<typename... Args>
+	void log(int level, const char* fmt, Args... args){
+		static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "too many arguments for a log record");
+		struct log_record* r = begin(level, fmt);
+		if(r == NULL){
+			return;
+		}
+		uint64_t words[] = {0, word(*r, args)...};
+		r->nargs = sizeof...(Args);
+		memcpy(r->args, words + 1, sizeof(words) - sizeof(uint64_t));
+		commit();
+	}
+	bool flush(bool wait = true);
+	uint64_t dropped();
+	uint64_t suppressed();
+private:
+	Logger();
+	static void release(void * ring);
+	struct log_record* begin(int level, const char* fmt);
+	void commit();
+	struct log_ring* ring();
+	void drain(struct log_ring* r, int id);
+	void format(const struct log_record& r, std::string& out);
+	static void write_all(FILE* f, std::string& out);
+	static void * process_log(void * args);
+	static void flush_at_exit();
+
+	static uint64_t word(struct log_record& r, const char* s);
+	static uint64_t word(struct log_record& r, char* s) { return word(r, (const char*) s); }
+	static uint64_t word(struct log_record& r, double d){
+		uint64_t w;
+		memcpy(&w, &d, sizeof(w));
+		return w;
+	}
+	static uint64_t word(struct log_record& r, const void* p) { return (uint64_t)(uintptr_t) p; }
+	template<typename T>
+	static uint64_t word(struct log_record& r, T v) { return (uint64_t)(int64_t) v; }
+
+	static std::atomic<int> _level;
+	static __thread struct log_ring* _local;
+	struct log_ring* _rings[LOG_MAX_THREADS];
+	std::atomic<int> _count;
+	std::atomic<uint64_t> _unringed;	// records lost because their thread had no ring
+	uint64_t _reportedUnringed;			// writer only
+	pthread_key_t _key;					// its destructor frees the ring of an exiting thread
+	pthread_mutex_t _lock;		// only taken by a thread making its ring
+	pthread_mutex_t _flushLock;	// taken by whoever drains, guards the rest
+	std::vector<struct log_record> _batch;
+	std::string _out, _err;
+	pthread_t tid;
+};
+
+#endif
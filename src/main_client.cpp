@@ -29,9 +29,13 @@ int main(int argc, char **argv)
 	char c;
 	int buflen = 255;
 	int connections = 1000;
+	int threads = 1;
+	double rate = 0;
+	double connectRate = 0;
+	int depth = 0;
 	const char* filename = "test/client.txt";
 	signal(SIGINT, signalHandler);  
-	while ((c = getopt (argc, argv, "a:p:t:b:c:")) != -1){
+	while ((c = getopt (argc, argv, "a:p:t:b:c:n:r:R:d:")) != -1){
          switch (c){
 			case 'p':
 				port= atoi(optarg);
@@ -48,9 +52,21 @@ int main(int argc, char **argv)
 			case 'c':
 				connections = atoi(optarg);
 				break;
+			case 'n':
+				threads = atoi(optarg);
+				break;
+			case 'r':
+				rate = atof(optarg);
+				break;
+			case 'R':
+				connectRate = atof(optarg);
+				break;
+			case 'd':
+				depth = atoi(optarg);
+				break;
 			case '?':
 			default:
-				fprintf(stderr, "Usage: %s [-a hostname] [-p port] [-t timesToSend] [-c maxConnect] [-b buflength]\n", argv[0]);
+				fprintf(stderr, "Usage: %s [-a hostname] [-p port] [-t timesToSend] [-c maxConnect] [-b buflength] [-n threads] [-r rate] [-R connectRate] [-d depth]\n", argv[0]);
 				exit(1);
 		}
 	}
@@ -68,6 +84,10 @@ int main(int argc, char **argv)
 	Client client(host, port, times_sent);
 	client.setBufLen(buflen);
 	client.setConnections(connections);
+	client.setThreads(threads);
+	client.setRate(rate);
+	client.setConnectRate(connectRate);
+	client.setDepth(depth);
 	client.run();
 	return 0;
 }
@@ -94,8 +114,10 @@ int main(int argc, char **argv)
 void* printThread(void * args){
 	const struct timespec timeout {1,0};
 
+	ThreadStats::set_role("stats");
 	while(1){
 		nanosleep(&timeout, NULL);
+		ThreadStats::tick(stat_now_ns());
 		ClientData::Instance()->print();
 	}
 	return (void*)0;
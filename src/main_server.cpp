@@ -1,9 +1,18 @@
 #include "multi_thread_server.h"
 #include "select_server.h"
 #include "epoll_server.h"
+#include "reactor_server.h"
+#include "uring_server.h"
+#include "output_buffer.h"
+#include "metrics_server.h"
+#include "stats_shm.h"
+#include "tracer.h"
+#include "profiler.h"
 #include <time.h>
 void* printThread(void * args);
 void signalHandler( int signum );
+void traceSignal( int signum );
+void profileSignal( int signum );
 
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: main (server)
@@ -33,11 +42,22 @@ int main(int argc, char **argv)
 	MultiThreadServer* server1;
 	SelectServer* server2;
 	EpollServer* server3;
+	ReactorServer* server4;
+	UringServer* server5;
 	const char* filename = "test/tests.txt";
 	int buflen = 255;
+	int highWatermark = OUTPUT_HIGH_WATERMARK;
+	bool useSplice = false;
+	int zerocopyThreshold = 0;
+	int backlog = SOMAXCONN;
+	int acceptThreads = 0;
+	int metricsPort = 0;
+	const char* shmName = NULL;
+	int traceRate = 0;
+	int profileHz = 0;
 	signal(SIGINT, signalHandler);  
 	//get args
-	while ((c = getopt (argc, argv, "f:n:p:t:b:n:")) != -1){
+	while ((c = getopt (argc, argv, "f:n:p:t:b:n:w:sz:l:a:m:S:T:L:i:P:")) != -1){
          switch (c){
 			case 'p':
 				port= atoi(optarg);
@@ -54,18 +74,79 @@ int main(int argc, char **argv)
 			case 'b':
 				buflen = atoi(optarg);
 				break;
+			case 'w':
+				highWatermark = atoi(optarg);
+				break;
+			case 's':
+				useSplice = true;
+				break;
+			case 'z':
+				zerocopyThreshold = atoi(optarg);
+				break;
+			case 'l':
+				backlog = atoi(optarg);
+				break;
+			case 'a':
+				acceptThreads = atoi(optarg);
+				break;
+			case 'm':
+				metricsPort = atoi(optarg);
+				break;
+			case 'S':
+				shmName = optarg;
+				break;
+			case 'T':
+				traceRate = atoi(optarg);
+				break;
+			case 'L':
+				Logger::set_level(atoi(optarg));
+				break;
+			case 'i':
+				ClientData::Instance()->setTcpSampling(atoi(optarg));
+				break;
+			case 'P':
+				profileHz = atoi(optarg);
+				break;
 			case '?':
 			default:
-				fprintf(stderr, "Usage: %s [-t servertype] [-p port] [-f filename] [-n numberOfWorkers] [-b buflength]\n", argv[0]);
+				fprintf(stderr, "Usage: %s [-t servertype] [-p port] [-f filename] [-n numberOfWorkers] [-b buflength] [-w highWatermark] [-s] [-z zerocopyThreshold] [-l backlog] [-a acceptThreads] [-m metricsPort] [-S shmName] [-T traceRate] [-L logLevel] [-i tcpInfoBatch] [-P profileHz]\n", argv[0]);
 				exit(1);
 		}
 	}
 	
+	// a client is paused with this much output pending and resumed at a quarter of it
+	OutputBuffer::set_default_watermarks(highWatermark / 4, highWatermark);
+
 	//set filename
 	if(ClientData::Instance()->setFile(filename) <0 ){
 		fprintf(stderr, "File could not be opened: %s\n", filename);
 		exit(1);
 	}
+	//open the metrics port before the stats thread starts publishing to it
+	if(metricsPort > 0){
+		MetricsServer::Instance()->set_port(metricsPort);
+		if(MetricsServer::Instance()->run() < 0){
+			exit(1);
+		}
+	}
+	//sample one request in traceRate through the epoll server's stages, dumped on SIGUSR1
+	if(traceRate > 0){
+		if(Tracer::Instance()->set_rate(traceRate) < 0){
+			exit(1);
+		}
+		signal(SIGUSR1, traceSignal);
+	}
+	//sample the stacks profileHz times a second of CPU time, dumped as folded stacks on SIGUSR2
+	if(profileHz > 0){
+		if(Profiler::Instance()->start(profileHz) < 0){
+			exit(1);
+		}
+		signal(SIGUSR2, profileSignal);
+	}
+	//publish live counters to shared memory for stats_reader
+	if(shmName != NULL && StatsShm::Instance()->open(shmName) < 0){
+		exit(1);
+	}
 	//create stat printing thread
 	pthread_t tid;
 	pthread_create(&tid, NULL, printThread, (void*)NULL);
@@ -76,21 +157,43 @@ int main(int argc, char **argv)
 			server1 = MultiThreadServer::Instance();
 			server1->set_port(port);
 			server1->setBufLen(buflen);
+			server1->set_backlog(backlog);
 			server1->run();
 			break;
 		case 2:
 			server2 = SelectServer::Instance();
 			server2->set_port(port);
 			server2->setBufLen(buflen);
+			server2->set_backlog(backlog);
 			server2->set_num_threads(numberWorkers);
 			server2->run();
 			break;
+		case 4:
+			server4 = ReactorServer::Instance();
+			server4->set_port(port);
+			server4->setBufLen(buflen);
+			server4->set_backlog(backlog);
+			server4->set_num_threads(numberWorkers);
+			server4->run();
+			break;
+		case 5:
+			server5 = UringServer::Instance();
+			server5->set_port(port);
+			server5->setBufLen(buflen);
+			server5->set_backlog(backlog);
+			server5->set_num_threads(numberWorkers);
+			server5->run();
+			break;
 		case 3:
 		default:
 			server3 = EpollServer::Instance();
 			server3->set_port(port);
 			server3->setBufLen(buflen);
+			server3->set_backlog(backlog);
 			server3->set_num_threads(numberWorkers);
+			server3->set_splice(useSplice);
+			server3->set_zerocopy(zerocopyThreshold);
+			server3->set_accept_threads(acceptThreads);
 			server3->run();
 			break;
 	}
@@ -107,6 +210,8 @@ int main(int argc, char **argv)
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - publishes to the metrics endpoint and the shared memory segment, writes trace and
+--					 profile dumps
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -116,20 +221,93 @@ int main(int argc, char **argv)
 --
 -- RETURNS:  0 on success
 --
--- NOTES: Thread that prints the number of clients to a file in a loop.
+-- NOTES: Thread that prints the number of clients to a file in a loop, and hands the same snapshot to the
+-- metrics endpoint when it is on.  With -S it also publishes a snapshot to shared memory every 10ms.
+-- Trace dumps asked for with SIGUSR1 and profile dumps asked for with SIGUSR2 are written from here.
 ----------------------------------------------------------------------------------------------------------------------*/
 
 void* printThread(void * args){
-	const struct timespec timeout {0,500000000};
+	// with a shared memory segment the thread wakes at its rate and prints every so many ticks
+	long tick = StatsShm::Instance()->enabled() ? STATS_SHM_INTERVAL_NS : 500000000;
+	const struct timespec timeout {0, tick};
+	const long ticksPerPrint = 500000000 / tick;
+	stats_snapshot snap;
+	long ticks = 0;
 
+	ThreadStats::set_role("stats");
 	while(1){
 		nanosleep(&timeout, NULL);
+		ThreadStats::tick(stat_now_ns());
+		if(StatsShm::Instance()->enabled()){
+			ClientData::Instance()->snapshot(snap);
+			StatsShm::Instance()->publish(snap);
+		}
+		if(Tracer::Instance()->dump_requested()){
+			Tracer::Instance()->dump_file(TRACE_FILE);
+		}
+		if(Profiler::Instance()->dump_requested()){
+			Profiler::Instance()->dump_file(PROFILE_FILE);
+		}
+		if(++ticks < ticksPerPrint){
+			continue;
+		}
+		ticks = 0;
 		ClientData::Instance()->print();
+		if(MetricsServer::Instance()->enabled()){
+			MetricsServer::Instance()->publish(ClientData::Instance()->latest());
+		}
 	}
 	return (void*)0;
 }
 void signalHandler( int signum )
 {
 	printf("Interupt: %d\n",signum);
+	StatsShm::Instance()->unlink();
 	ClientData::Instance()->cleanup(signum);
 }
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: traceSignal
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void traceSignal( int signum )
+--				int signum - SIGUSR1
+--
+-- RETURNS:  void
+--
+-- NOTES: Only flags the dump; the stats thread writes it within one tick.
+----------------------------------------------------------------------------------------------------------------------*/
+void traceSignal( int signum )
+{
+	Tracer::Instance()->request_dump();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: profileSignal
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void profileSignal( int signum )
+--				int signum - SIGUSR2
+--
+-- RETURNS:  void
+--
+-- NOTES: Only flags the dump; the stats thread writes it within one tick.
+----------------------------------------------------------------------------------------------------------------------*/
+void profileSignal( int signum )
+{
+	Profiler::Instance()->request_dump();
+}
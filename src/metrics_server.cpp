@@ -0,0 +1,571 @@
+#include "metrics_server.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: metrics_server.cpp - Hold the code for the metrics endpoint of the server.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: static void append(std::string& page, const char * fmt, ...)
+--			  MetricsServer::MetricsServer()
+--			  MetricsServer* MetricsServer::Instance()
+--			  int MetricsServer::run()
+--			  int MetricsServer::set_port(int port)
+--			  bool MetricsServer::enabled()
+--			  void MetricsServer::publish(const stats_snapshot& now)
+--			  void MetricsServer::format(const stats_snapshot& now, std::string& page)
+--			  void * MetricsServer::process_scrapes(void * args)
+--			  int MetricsServer::read_request(int sock, char * path, int len)
+--			  int MetricsServer::respond(int sock, const char * path)
+--			  int MetricsServer::send_all(int sock, const char * data, size_t len)
+--
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: A minimal HTTP/1.0 listener on the loopback address for a prometheus scraper.  One thread answers the
+-- scrapes one at a time; the page itself is built by the stats thread from the snapshot it already takes for
+-- the stats file.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: append
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static void append(std::string& page, const char * fmt, ...)
+--					std::string& page - text the line is added to
+--					const char * fmt  - printf format of the line
+--
+-- RETURNS:  void
+--
+-- NOTES: printf onto the end of a string.  Lines longer than 255 characters are cut.
+----------------------------------------------------------------------------------------------------------------------*/
+static void append(std::string& page, const char * fmt, ...)
+{
+	char line[256];
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+	if(n > 0){
+		page.append(line, n < (int) sizeof(line) ? n : sizeof(line) - 1);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: MetricsServer (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: MetricsServer::MetricsServer()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: The endpoint is off until a port is set.
+----------------------------------------------------------------------------------------------------------------------*/
+MetricsServer::MetricsServer() : serverSock(-1), _port(0), _hasPrev(false)
+{
+	pthread_mutex_init(&_lock, NULL);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: MetricsServer* MetricsServer::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates an instance of the metrics server.
+----------------------------------------------------------------------------------------------------------------------*/
+MetricsServer* MetricsServer::Instance()
+{
+	static MetricsServer m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: run
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MetricsServer::run()
+--
+-- RETURNS:  0 on success, -1 if the port could not be opened
+--
+-- NOTES: Listens on 127.0.0.1 only and starts the scrape thread.  Returns straight away.
+----------------------------------------------------------------------------------------------------------------------*/
+int MetricsServer::run()
+{
+	struct sockaddr_in server;
+	int arg = 1;
+
+	if ((serverSock = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1)
+	{
+		perror("Cannot create metrics socket");
+		return -1;
+	}
+	if (setsockopt (serverSock, SOL_SOCKET, SO_REUSEADDR, &arg, sizeof(arg)) == -1){
+		perror("setsockopt");
+	}
+	bzero((char *)&server, sizeof(struct sockaddr_in));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(_port);
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);	// scrapers on other hosts go through a local agent
+
+	if (bind(serverSock, (struct sockaddr *)&server, sizeof(server)) == -1 || listen(serverSock, 16) == -1)
+	{
+		perror("Can't open the metrics port");
+		close(serverSock);
+		serverSock = -1;
+		return -1;
+	}
+	if (pthread_create(&tid, NULL, process_scrapes, NULL) != 0)
+	{
+		fprintf(stderr, "pthread_create metrics\n");
+		close(serverSock);
+		serverSock = -1;
+		return -1;
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_port
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MetricsServer::set_port(int port)
+--					int port - local port for the scraper
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets the port run() listens on.
+----------------------------------------------------------------------------------------------------------------------*/
+int MetricsServer::set_port(int port){
+	_port = port;
+	return 1;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: enabled
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: bool MetricsServer::enabled()
+--
+-- RETURNS:  true once run() has opened the port
+--
+-- NOTES: The stats thread skips formatting the page when nobody can scrape it.
+----------------------------------------------------------------------------------------------------------------------*/
+bool MetricsServer::enabled(){
+	return serverSock >= 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: publish
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void MetricsServer::publish(const stats_snapshot& now)
+--					const stats_snapshot& now - the snapshot the stats thread just took
+--
+-- RETURNS:  void
+--
+-- NOTES: Called by the stats thread each interval.  The page is formatted before the lock is taken, so the lock
+-- is only held to swap a pointer; a scrape in progress keeps the old page alive until it is sent.
+----------------------------------------------------------------------------------------------------------------------*/
+void MetricsServer::publish(const stats_snapshot& now){
+	std::string* page = new std::string();
+	page->reserve(8192);
+	format(now, *page);
+	std::shared_ptr<const std::string> ready(page);
+
+	pthread_mutex_lock(&_lock);
+	_page.swap(ready);
+	pthread_mutex_unlock(&_lock);
+
+	_prev = now;
+	_hasPrev = true;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: format
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void MetricsServer::format(const stats_snapshot& now, std::string& page)
+--					const stats_snapshot& now - totals to report
+--					std::string& page         - receives the text exposition
+--
+-- RETURNS:  void
+--
+-- NOTES: Counters are the totals since start so the scraper can take its own rates; the per second gauges
+-- cover the last stats interval.  The rtt histogram is cut down to one bucket per power of two, whose tops
+-- (2^k - 1) are also bucket tops of the full histogram, so the cumulative counts are exact.
+----------------------------------------------------------------------------------------------------------------------*/
+void MetricsServer::format(const stats_snapshot& now, std::string& page){
+	double elapsed = 0;
+	if(_hasPrev){
+		elapsed = (now.when.tv_sec - _prev.when.tv_sec) + (now.when.tv_nsec - _prev.when.tv_nsec) / 1e9;
+	}
+
+	append(page, "# HELP scalable_server_clients Connected clients.\n");
+	append(page, "# TYPE scalable_server_clients gauge\n");
+	append(page, "scalable_server_clients %ld\n", now.clients);
+	append(page, "# HELP scalable_server_accepts_total Connections accepted.\n");
+	append(page, "# TYPE scalable_server_accepts_total counter\n");
+	append(page, "scalable_server_accepts_total %lu\n", (unsigned long) now.accepts);
+	append(page, "# HELP scalable_server_messages_total Messages echoed.\n");
+	append(page, "# TYPE scalable_server_messages_total counter\n");
+	append(page, "scalable_server_messages_total %lu\n", (unsigned long) now.messages);
+	append(page, "# HELP scalable_server_bytes_total Bytes echoed.\n");
+	append(page, "# TYPE scalable_server_bytes_total counter\n");
+	append(page, "scalable_server_bytes_total %lu\n", (unsigned long) now.bytes);
+	append(page, "# HELP scalable_server_messages_per_second Messages echoed per second over the last stats interval.\n");
+	append(page, "# TYPE scalable_server_messages_per_second gauge\n");
+	append(page, "scalable_server_messages_per_second %.1f\n", elapsed > 0 ? (now.messages - _prev.messages) / elapsed : 0.0);
+	append(page, "# HELP scalable_server_bytes_per_second Bytes echoed per second over the last stats interval.\n");
+	append(page, "# TYPE scalable_server_bytes_per_second gauge\n");
+	append(page, "scalable_server_bytes_per_second %.1f\n", elapsed > 0 ? (now.bytes - _prev.bytes) / elapsed : 0.0);
+	if(now.queue_depth >= 0){
+		append(page, "# HELP scalable_server_queue_depth Ready connections waiting for a worker.\n");
+		append(page, "# TYPE scalable_server_queue_depth gauge\n");
+		append(page, "scalable_server_queue_depth %ld\n", now.queue_depth);
+		append(page, "# HELP scalable_server_queue_high_water Deepest the worker queue got over the last stats interval.\n");
+		append(page, "# TYPE scalable_server_queue_high_water gauge\n");
+		append(page, "scalable_server_queue_high_water %ld\n", now.queue_high_water);
+		append(page, "# HELP scalable_server_queue_push_timeouts_total Connections dropped because the worker queue stayed full.\n");
+		append(page, "# TYPE scalable_server_queue_push_timeouts_total counter\n");
+		append(page, "scalable_server_queue_push_timeouts_total %lu\n", (unsigned long) now.push_timeouts);
+	}
+
+	append(page, "# HELP scalable_server_rtt_microseconds Time between two messages on a connection.\n");
+	append(page, "# TYPE scalable_server_rtt_microseconds histogram\n");
+	uint64_t seen = 0;
+	int bucket = 0;
+	for(int k = 1; k <= METRICS_RTT_BITS; k++){
+		uint64_t le = (1ULL << k) - 1;
+		while(bucket < HIST_BUCKETS && Histogram::highest(bucket) <= le){
+			seen += now.rtt.count(bucket++);
+		}
+		append(page, "scalable_server_rtt_microseconds_bucket{le=\"%lu\"} %lu\n", (unsigned long) le, (unsigned long) seen);
+	}
+	append(page, "scalable_server_rtt_microseconds_bucket{le=\"+Inf\"} %lu\n", (unsigned long) now.rtt.total());
+	append(page, "scalable_server_rtt_microseconds_sum %lu\n", (unsigned long) now.rtt_sum);
+	append(page, "scalable_server_rtt_microseconds_count %lu\n", (unsigned long) now.rtt.total());
+
+	append(page, "# HELP scalable_server_worker_busy_seconds_total Time each worker spent handling work rather than waiting.\n");
+	append(page, "# TYPE scalable_server_worker_busy_seconds_total counter\n");
+	int n = ThreadStats::count();
+	for(int i = 0; i < n; i++){
+		thread_stats* t = ThreadStats::at(i);
+		const char* role = t->role.load(std::memory_order_relaxed);
+		if(role != NULL && t->timed.load(std::memory_order_relaxed)){
+			append(page, "scalable_server_worker_busy_seconds_total{thread=\"%d\",role=\"%s\"} %.6f\n",
+				i, role, t->busy_ns.load(std::memory_order_relaxed) / 1e9);
+		}
+	}
+	append(page, "# HELP scalable_server_thread_cpu_seconds_total CPU time of each thread, sampled every 10ms while it runs.\n");
+	append(page, "# TYPE scalable_server_thread_cpu_seconds_total counter\n");
+	for(int i = 0; i < n; i++){
+		thread_stats* t = ThreadStats::at(i);
+		const char* role = t->role.load(std::memory_order_relaxed);
+		append(page, "scalable_server_thread_cpu_seconds_total{thread=\"%d\",role=\"%s\"} %.6f\n",
+			i, role != NULL ? role : "other", t->cpu_ns.load(std::memory_order_relaxed) / 1e9);
+	}
+	append(page, "# HELP scalable_server_context_switches_total Context switches of each thread, voluntary (blocked) or not (preempted).\n");
+	append(page, "# TYPE scalable_server_context_switches_total counter\n");
+	for(int i = 0; i < n; i++){
+		thread_stats* t = ThreadStats::at(i);
+		const char* role = t->role.load(std::memory_order_relaxed);
+		append(page, "scalable_server_context_switches_total{thread=\"%d\",role=\"%s\",kind=\"voluntary\"} %lu\n",
+			i, role != NULL ? role : "other", (unsigned long) t->csw_voluntary.load(std::memory_order_relaxed));
+		append(page, "scalable_server_context_switches_total{thread=\"%d\",role=\"%s\",kind=\"involuntary\"} %lu\n",
+			i, role != NULL ? role : "other", (unsigned long) t->csw_involuntary.load(std::memory_order_relaxed));
+	}
+
+	append(page, "# HELP scalable_server_sends_total Echoes sent, by copy or MSG_ZEROCOPY.\n");
+	append(page, "# TYPE scalable_server_sends_total counter\n");
+	append(page, "scalable_server_sends_total{mode=\"copied\"} %lu\n", (unsigned long) now.sends_copied);
+	append(page, "scalable_server_sends_total{mode=\"zerocopy\"} %lu\n", (unsigned long) now.sends_zerocopy);
+	append(page, "# HELP scalable_server_zerocopy_completed_total MSG_ZEROCOPY sends completed, and how many the kernel copied.\n");
+	append(page, "# TYPE scalable_server_zerocopy_completed_total counter\n");
+	append(page, "scalable_server_zerocopy_completed_total{copied=\"false\"} %lu\n", (unsigned long) (now.zerocopy_done - now.zerocopy_copied));
+	append(page, "scalable_server_zerocopy_completed_total{copied=\"true\"} %lu\n", (unsigned long) now.zerocopy_copied);
+	if(now.tcp.sampled > 0){
+		append(page, "# HELP scalable_server_tcp_sampled_connections Connections whose TCP_INFO was read in the last interval.\n");
+		append(page, "# TYPE scalable_server_tcp_sampled_connections gauge\n");
+		append(page, "scalable_server_tcp_sampled_connections %ld\n", now.tcp.sampled);
+		append(page, "# HELP scalable_server_tcp_rtt_microseconds Kernel smoothed rtt of the sampled connections.\n");
+		append(page, "# TYPE scalable_server_tcp_rtt_microseconds gauge\n");
+		append(page, "scalable_server_tcp_rtt_microseconds{stat=\"avg\"} %.0lf\n", (double) now.tcp.rtt_sum / now.tcp.sampled);
+		append(page, "scalable_server_tcp_rtt_microseconds{stat=\"max\"} %lu\n", (unsigned long) now.tcp.rtt_max);
+		append(page, "scalable_server_tcp_rtt_microseconds{stat=\"rttvar_avg\"} %.0lf\n", (double) now.tcp.rttvar_sum / now.tcp.sampled);
+		append(page, "# HELP scalable_server_tcp_cwnd_segments Average congestion window of the sampled connections.\n");
+		append(page, "# TYPE scalable_server_tcp_cwnd_segments gauge\n");
+		append(page, "scalable_server_tcp_cwnd_segments %.1lf\n", (double) now.tcp.cwnd_sum / now.tcp.sampled);
+		append(page, "# HELP scalable_server_tcp_unacked_bytes Bytes in flight on the sampled connections.\n");
+		append(page, "# TYPE scalable_server_tcp_unacked_bytes gauge\n");
+		append(page, "scalable_server_tcp_unacked_bytes{stat=\"avg\"} %.0lf\n", (double) now.tcp.unacked_sum / now.tcp.sampled);
+		append(page, "scalable_server_tcp_unacked_bytes{stat=\"max\"} %lu\n", (unsigned long) now.tcp.unacked_max);
+		append(page, "# HELP scalable_server_tcp_retransmits Lifetime retransmits of the sampled connections.\n");
+		append(page, "# TYPE scalable_server_tcp_retransmits gauge\n");
+		append(page, "scalable_server_tcp_retransmits %lu\n", (unsigned long) now.tcp.retrans);
+		append(page, "# HELP scalable_server_tcp_recovering_connections Sampled connections retransmitting or in loss recovery.\n");
+		append(page, "# TYPE scalable_server_tcp_recovering_connections gauge\n");
+		append(page, "scalable_server_tcp_recovering_connections %ld\n", now.tcp.recovering);
+	}
+	append(page, "# HELP scalable_server_log_lost_total Log records lost to a full ring or held back by the rate limit.\n");
+	append(page, "# TYPE scalable_server_log_lost_total counter\n");
+	append(page, "scalable_server_log_lost_total{reason=\"ring_full\"} %lu\n", (unsigned long) Logger::Instance()->dropped());
+	append(page, "scalable_server_log_lost_total{reason=\"rate_limit\"} %lu\n", (unsigned long) Logger::Instance()->suppressed());
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_scrapes
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * MetricsServer::process_scrapes(void * args)
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Scrape thread.  Answers one request per connection and closes it.  Every scraper gets a time limit
+-- so a stuck one cannot hold up the next.
+----------------------------------------------------------------------------------------------------------------------*/
+void * MetricsServer::process_scrapes(void * args)
+{
+	MetricsServer* mServer = MetricsServer::Instance();
+	struct timeval limit = {METRICS_TIMEOUT, 0};
+	char path[METRICS_REQUEST_LEN];
+	int sock;
+
+	ThreadStats::set_role("metrics");
+	while(1){
+		if ((sock = accept4(mServer->serverSock, NULL, NULL, SOCK_CLOEXEC)) == -1)
+		{
+			if(errno == EINTR || errno == ECONNABORTED || errno == EMFILE || errno == ENFILE){
+				continue;
+			}
+			perror("Can't accept scraper");
+			break;
+		}
+		setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &limit, sizeof(limit));
+		setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &limit, sizeof(limit));
+		if(mServer->read_request(sock, path, sizeof(path)) == 0){
+			mServer->respond(sock, path);
+		}
+		close(sock);
+		ThreadStats::tick(stat_now_ns());
+	}
+	return (void*)0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read_request
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MetricsServer::read_request(int sock, char * path, int len)
+--					int sock   - scraper socket
+--					char * path - receives the requested path, without the query string
+--					int len    - size of path
+--
+-- RETURNS:  0 on success, -1 if the request was not a GET or did not arrive in time
+--
+-- NOTES: Reads up to the end of the request head.  The headers are ignored.
+----------------------------------------------------------------------------------------------------------------------*/
+int MetricsServer::read_request(int sock, char * path, int len)
+{
+	char head[METRICS_REQUEST_LEN];
+	int n, total = 0;
+
+	head[0] = '\0';
+	while(total < (int) sizeof(head) - 1 && strstr(head, "\r\n\r\n") == NULL && strstr(head, "\n\n") == NULL){
+		if((n = recv(sock, head + total, sizeof(head) - 1 - total, 0)) <= 0){
+			break;
+		}
+		total += n;
+		head[total] = '\0';
+	}
+	if(strncmp(head, "GET ", 4) != 0){
+		return -1;
+	}
+	int i = 0;
+	for(const char * p = head + 4; *p != ' ' && *p != '?' && *p != '\r' && *p != '\n' && *p != '\0' && i < len - 1; p++){
+		path[i++] = *p;
+	}
+	path[i] = '\0';
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: respond
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MetricsServer::respond(int sock, const char * path)
+--					int sock          - scraper socket
+--					const char * path - requested path
+--
+-- RETURNS:  0 on success, -1 if the response could not be sent
+--
+-- NOTES: Serves the current page on /metrics (and /).  Before the first stats interval there is no page yet
+-- and the scraper is told to come back.  /trace dumps the sampled request traces when tracing is on; the
+-- rings are read in place, so this takes no lock either.  /profile serves the folded stacks of the sampling
+-- profiler when it is on.
+----------------------------------------------------------------------------------------------------------------------*/
+int MetricsServer::respond(int sock, const char * path)
+{
+	char header[256];
+	std::shared_ptr<const std::string> page;
+	std::string trace;
+	const char * status = "200 OK";
+	const char * type = "text/plain; version=0.0.4";
+	const char * body;
+	size_t len;
+
+	if(strcmp(path, "/metrics") == 0 || strcmp(path, "/") == 0){
+		pthread_mutex_lock(&_lock);
+		page = _page;
+		pthread_mutex_unlock(&_lock);
+		if(page){
+			body = page->data();
+			len = page->size();
+		} else {
+			status = "503 Service Unavailable";
+			body = "no stats yet\n";
+			len = strlen(body);
+		}
+	} else if(strcmp(path, "/trace") == 0 && Tracer::Instance()->enabled()){
+		Tracer::Instance()->dump(trace);
+		type = "application/json";
+		body = trace.data();
+		len = trace.size();
+	} else if(strcmp(path, "/profile") == 0 && Profiler::Instance()->enabled()){
+		Profiler::Instance()->dump(trace);
+		type = "text/plain";
+		body = trace.data();
+		len = trace.size();
+	} else {
+		status = "404 Not Found";
+		body = "not found\n";
+		len = strlen(body);
+	}
+	int n = snprintf(header, sizeof(header), "HTTP/1.0 %s\r\nContent-Type: %s\r\n"
+		"Content-Length: %lu\r\nConnection: close\r\n\r\n", status, type, (unsigned long) len);
+	if(send_all(sock, header, n) < 0 || send_all(sock, body, len) < 0){
+		return -1;
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: send_all
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MetricsServer::send_all(int sock, const char * data, size_t len)
+--					int sock          - scraper socket
+--					const char * data - bytes to send
+--					size_t len        - number of bytes
+--
+-- RETURNS:  0 on success, -1 on error or timeout
+--
+-- NOTES: A scraper that goes away does not raise SIGPIPE.
+----------------------------------------------------------------------------------------------------------------------*/
+int MetricsServer::send_all(int sock, const char * data, size_t len)
+{
+	ssize_t n;
+	while(len > 0){
+		if((n = send(sock, data, len, MSG_NOSIGNAL)) <= 0){
+			if(n < 0 && errno == EINTR){
+				continue;
+			}
+			return -1;
+		}
+		data += n;
+		len -= n;
+	}
+	return 0;
+}
@@ -0,0 +1,61 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include "client_data.h"
+#include "thread_stats.h"
+#include "tracer.h"
+#include "profiler.h"
+
+#include <memory>
+#include <string>
+#include <stdio.h>
+#include <stdarg.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <unistd.h>
+#include <string.h>
+#include <pthread.h>
+
+#define METRICS_REQUEST_LEN 1024	// longest request head read from a scraper
+#define METRICS_TIMEOUT 2			// seconds a scraper gets to send its request or read the page
+#define METRICS_RTT_BITS 26			// rtt buckets go up to 2^26 us (about 67s), the rest is in +Inf
+
+/**
+serves the statistics in the prometheus text format on a local port.  the
+page is formatted by the stats thread each interval and swapped in whole; a
+scrape only copies the pointer to the current page, so it never touches
+anything the echo workers use.
+*/
+class MetricsServer {
+
+public:
+	static MetricsServer* Instance();
+
+	int run();
+	int set_port(int port);
+	bool enabled();
+	void publish(const stats_snapshot& now);
+private:
+	MetricsServer();
+	static void * process_scrapes(void * args);
+	int read_request(int sock, char * path, int len);
+	int respond(int sock, const char * path);
+	int send_all(int sock, const char * data, size_t len);
+	void format(const stats_snapshot& now, std::string& page);
+
+	int 	serverSock, _port;
+	pthread_t tid;
+	// guards _page only, and is only taken by the stats thread and the scrape thread
+	pthread_mutex_t _lock;
+	std::shared_ptr<const std::string> _page;
+	// totals at the previous publish, for the rates
+	stats_snapshot _prev;
+	bool _hasPrev;
+};
+
+#endif
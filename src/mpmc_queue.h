@@ -0,0 +1,254 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "thread_stats.h"
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+/**
+bounded lock-free multi-producer/multi-consumer ring with the same push/pop
+with timeout contract as blocking_queue.
+
+the ring is the sequence-numbered cell array from Dmitry Vyukov's bounded mpmc
+queue: producers and consumers only CAS their own position counter, which live
+on separate cache lines, and every cell sits on its own line so neighbouring
+slots do not false-share.
+
+a push or pop that finds the ring full/empty spins for an adaptive number of
+rounds, then parks on a condition variable.  the mutex is only ever touched by
+threads that are parking or waking a parked thread, never on the fast path.
+
+for the stats, producers keep the deepest the ring has been and count push
+timeouts, and push/pop can report how long they waited, by stat_now_ns() like
+every other wait the server times.  the clock is only read once a push or pop
+has found the ring full/empty.
+*/
+template<typename T>
+class mpmc_queue {
+public:
+    typedef std::size_t size_type;
+    mpmc_queue() : mpmc_queue(100) {}
+    explicit mpmc_queue(std::size_t max_size) : _enqueue_pos(0), _high_water(0), _dequeue_pos(0),
+        _push_waiters(0), _pop_waiters(0), _spin_limit(SPIN_MAX / 4), _push_timeouts(0)
+    {
+        _capacity = 2;
+        while (_capacity < max_size)
+            _capacity <<= 1;
+        _mask = _capacity - 1;
+        void* mem = NULL;
+        if (posix_memalign(&mem, CACHE_LINE, _capacity * sizeof(cell)) != 0)
+            throw std::bad_alloc();
+        _cells = static_cast<cell*>(mem);
+        for (size_type i = 0; i < _capacity; ++i) {
+            new (&_cells[i]) cell();
+            _cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+    mpmc_queue(const mpmc_queue&) = delete;
+    mpmc_queue& operator=(const mpmc_queue&) = delete;
+    ~mpmc_queue()
+    {
+        for (size_type i = 0; i < _capacity; ++i)
+            _cells[i].~cell();
+        free(_cells);
+    }
+
+    //Approximate, lock-free: may be stale by the time it returns
+    size_type size()
+    {
+        size_type tail = _enqueue_pos.load(std::memory_order_relaxed);
+        size_type head = _dequeue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+    size_type capacity() const { return _capacity; }
+    //Deepest the queue has been since the last reset, which starts over from the current size
+    size_type high_water(bool reset)
+    {
+        if (reset)
+            return _high_water.exchange(size(), std::memory_order_relaxed);
+        return _high_water.load(std::memory_order_relaxed);
+    }
+    //Number of pushes that gave up after their timeout
+    uint64_t push_timeouts() const { return _push_timeouts.load(std::memory_order_relaxed); }
+
+    //Return false if the queue is full right now
+    bool try_push(const T& item)
+    {
+        if (!enqueue(item))
+            return false;
+        wake(_pop_waiters, _item_pushed_cond);
+        return true;
+    }
+    //Return false if the queue is empty right now
+    bool try_pop(T& item)
+    {
+        if (!dequeue(item))
+            return false;
+        wake(_push_waiters, _item_popped_cond);
+        return true;
+    }
+    //Return false if failed to push due to full queue after the timeout have passed.
+    //waited_ns, if given, gets the time spent waiting for room, 0 when there was no wait
+    bool push(const T& item, const std::chrono::milliseconds& timeout, uint64_t* waited_ns = NULL)
+    {
+        if (!wait([&]() { return this->enqueue(item); }, _push_waiters, _item_popped_cond, timeout, waited_ns)) {
+            _push_timeouts.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        wake(_pop_waiters, _item_pushed_cond);
+        return true;
+    }
+    //Return false if failed to pop due to empty queue after the timeout have passed.
+    //waited_ns, if given, gets the time spent waiting for an item, 0 when there was no wait
+    bool pop(T& item, const std::chrono::milliseconds& timeout, uint64_t* waited_ns = NULL)
+    {
+        if (!wait([&]() { return this->dequeue(item); }, _pop_waiters, _item_pushed_cond, timeout, waited_ns))
+            return false;
+        wake(_push_waiters, _item_popped_cond);
+        return true;
+    }
+private:
+    enum { SPIN_MIN = 16, SPIN_MAX = 4096 };
+
+    struct alignas(CACHE_LINE) cell {
+        std::atomic<size_type> seq;
+        T data;
+    };
+
+    bool enqueue(const T& item)
+    {
+        cell* c;
+        size_type pos = _enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &_cells[pos & _mask];
+            size_type seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+            if (dif == 0) {
+                if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        c->data = item;
+        c->seq.store(pos + 1, std::memory_order_release);
+        size_type head = _dequeue_pos.load(std::memory_order_relaxed);
+        size_type depth = pos + 1 > head ? pos + 1 - head : 0;
+        size_type high = _high_water.load(std::memory_order_relaxed);
+        while (depth > high && !_high_water.compare_exchange_weak(high, depth, std::memory_order_relaxed))
+            ;
+        return true;
+    }
+    bool dequeue(T& item)
+    {
+        cell* c;
+        size_type pos = _dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            c = &_cells[pos & _mask];
+            size_type seq = c->seq.load(std::memory_order_acquire);
+            intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (dif == 0) {
+                if (_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = _dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        item = c->data;
+        c->seq.store(pos + _mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    static void cpu_relax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    //spin-then-park.  the spin budget grows when spinning pays off and shrinks
+    //when a thread ends up parking anyway, so an idle pool stops burning cpu.
+    template<typename Op>
+    bool wait(Op op, std::atomic<int>& waiters, std::condition_variable& cond,
+              const std::chrono::milliseconds& timeout, uint64_t* waited_ns)
+    {
+        if (op()) {
+            if (waited_ns)
+                *waited_ns = 0;
+            return true;
+        }
+        uint64_t start = stat_now_ns();
+        int limit = _spin_limit.load(std::memory_order_relaxed);
+        for (int i = 0; i < limit; ++i) {
+            cpu_relax();
+            if (op()) {
+                if (limit < SPIN_MAX)
+                    _spin_limit.store(limit * 2, std::memory_order_relaxed);
+                waited(start, waited_ns);
+                return true;
+            }
+        }
+        if (limit > SPIN_MIN)
+            _spin_limit.store(limit / 2, std::memory_order_relaxed);
+
+        auto wait_until = std::chrono::steady_clock::now() + timeout;
+        std::unique_lock<std::mutex> ul(_mutex);
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool ok = cond.wait_until(ul, wait_until, [&]() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return op();
+        });
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        waited(start, waited_ns);
+        return ok;
+    }
+    static void waited(uint64_t start, uint64_t* waited_ns)
+    {
+        if (waited_ns)
+            *waited_ns = stat_now_ns() - start;
+    }
+    //the fence pairs with the one in wait(): either the parked thread sees our
+    //update when it re-checks, or we see its waiter count and signal it.
+    void wake(std::atomic<int>& waiters, std::condition_variable& cond)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0)
+            return;
+        { std::lock_guard<std::mutex> lock(_mutex); }
+        cond.notify_one();
+    }
+
+    cell* _cells;
+    size_type _capacity;
+    size_type _mask;
+    alignas(CACHE_LINE) std::atomic<size_type> _enqueue_pos;
+    std::atomic<size_type> _high_water;     //only raised by producers, on their line
+    alignas(CACHE_LINE) std::atomic<size_type> _dequeue_pos;
+    alignas(CACHE_LINE) std::atomic<int> _push_waiters;
+    std::atomic<int> _pop_waiters;
+    std::atomic<int> _spin_limit;
+    std::atomic<uint64_t> _push_timeouts;
+    std::mutex _mutex;
+    std::condition_variable _item_pushed_cond;
+    std::condition_variable _item_popped_cond;
+};
+
+#endif
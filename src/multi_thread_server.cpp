@@ -12,12 +12,13 @@
 --			  int MultiThreadServer::bind_socket()
 --			  void MultiThreadServer::listen_for_clients()
 --			  int MultiThreadServer::accept_client()
---			  void MultiThreadServer::send_msgs(int socket, char * data)
+--			  int MultiThreadServer::send_msgs(int socket, char * data)
 --			  int MultiThreadServer::recv_msgs(int socket, char * bp)
 --			  int MultiThreadServer::set_sock_option(int listenSocket)
 --			  void * MultiThreadServer::process_client(void * args)
 --			  int MultiThreadServer::set_port(int port)
 --			  int MultiThreadServer::setBufLen(int buflen)
+--			  int MultiThreadServer::set_backlog(int backlog)
 --			  
 --
 -- DATE: 2014/02/21
@@ -105,9 +106,11 @@ int MultiThreadServer::run()
 	serverSock = set_sock_option(serverSock);
 	listen_for_clients();
 
+	ThreadStats::set_role("acceptor");
 	for(int i = 0; i < MAXCLIENTS; i++)
 	{
 		socks[i] = accept_client();
+		ThreadStats::tick(stat_now_ns());
 		pthread_create(&tids[i], NULL, process_client, (void*)&(socks[i]));
 	}
 	for(int i = 0; i < MAXCLIENTS; i++)
@@ -201,8 +204,7 @@ int MultiThreadServer::bind_socket()
 void MultiThreadServer::listen_for_clients()
 {
 	// Listen for connections
-	// queue up to 10000 connect requests
-	listen(serverSock, 5);
+	listen(serverSock, _backlog);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -211,6 +213,7 @@ void MultiThreadServer::listen_for_clients()
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - sets TCP_NODELAY on the connection
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -221,6 +224,7 @@ void MultiThreadServer::listen_for_clients()
 -- RETURNS:  New Socket Descriptor
 --
 -- NOTES: Function that blocks until a client connection request comes in. It will add the client to the list.
+-- The connection gets TCP_NODELAY.
 ----------------------------------------------------------------------------------------------------------------------*/
 int MultiThreadServer::accept_client()
 {
@@ -234,7 +238,13 @@ int MultiThreadServer::accept_client()
 		exit(1);
 	}
 	
+	int nodelay = 1;
+	if (setsockopt (sServerSock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+		perror("setsockopt TCP_NODELAY");
+	}
+
 	ClientData::Instance()->addClient(sServerSock, inet_ntoa(client.sin_addr),client.sin_port );
+	ClientData::Instance()->recordAccept(1);
 	//printf("size of client data: %d\n", ClientData::Instance()->print());
 //	printf(" Remote Address:  %s\n", inet_ntoa(client.sin_addr));
 	return sServerSock;
@@ -251,17 +261,29 @@ int MultiThreadServer::accept_client()
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: void MultiThreadServer::send_msgs(int socket, char * data)
+-- INTERFACE: int MultiThreadServer::send_msgs(int socket, char * data)
 --						int socket - server sock
 --						char * data - data that the server will send back to the client
 --
--- RETURNS:  void
+-- RETURNS:  0 on success, -1 if the socket failed
 --
--- NOTES: Send Messages function used by the multi-thread server.
+-- NOTES: Send Messages function used by the multi-thread server.  The socket is blocking and owned by this
+-- thread alone, so short writes are simply retried: a slow reader only holds up its own thread.
 ----------------------------------------------------------------------------------------------------------------------*/
-void MultiThreadServer::send_msgs(int socket, char * data)
+int MultiThreadServer::send_msgs(int socket, char * data)
 {
-	send(socket, data, BUFLEN, 0);
+	int n, bytes_to_send = BUFLEN;
+	while (bytes_to_send > 0)
+	{
+		if ((n = send(socket, data, bytes_to_send, MSG_NOSIGNAL)) == -1){
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		data += n;
+		bytes_to_send -= n;
+	}
+	return 0;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -293,11 +315,10 @@ int MultiThreadServer::recv_msgs(int socket, char * bp)
 		bp += n;
 		bytes_to_read -= n;
 		if(n == -1){
-			printf("error %d %d %d\n", bytes_to_read, n, socket);
-			printf("error %d\n",errno);
+			LOG_WARN("recv error %d on socket %d, %d bytes to read", errno, socket, bytes_to_read);
 			break;
 		} else if (n == 0){
-			printf("socket was gracefully closed by other side %d\n",socket);
+			LOG_INFO("socket was gracefully closed by other side %d", socket);
 			ClientData::Instance()->removeClient(socket);
 			pthread_exit(NULL);
 			break;
@@ -367,12 +388,18 @@ void * MultiThreadServer::process_client(void * args)
 
 	char buf[BUFLEN];
 	MultiThreadServer* mServer = MultiThreadServer::Instance();
+	ThreadStats::set_role("connection");
 	while (! ClientData::Instance()->empty()){
 		mServer->recv_msgs(sock, buf);
+		ThreadStats::tick(stat_now_ns());
 
 		ClientData::Instance()->setRtt(sock);
 
-		mServer->send_msgs(sock, buf);	
+		if(mServer->send_msgs(sock, buf) < 0){
+			ClientData::Instance()->removeClient(sock);
+			close(sock);
+			break;
+		}
 		ClientData::Instance()->recordData(sock, BUFLEN);
 	}
 	return (void*)0;
@@ -423,4 +450,25 @@ int MultiThreadServer::setBufLen(int buflen){
 	_buflen = buflen;
 	return 1;
 }
-
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_backlog
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int MultiThreadServer::set_backlog(int backlog)
+--					int backlog - length of the listen queue
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets how many pending connections the listen socket queues.  The kernel caps it at somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int MultiThreadServer::set_backlog(int backlog){
+	_backlog = backlog;
+	return 1;
+}
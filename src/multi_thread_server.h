@@ -36,14 +36,15 @@ public:
 	int bind_socket();
 	void listen_for_clients();
 	int accept_client();
-	void send_msgs(int socket, char * data);
+	int send_msgs(int socket, char * data);
 	int recv_msgs(int socket, char * bp);
 	int set_sock_option(int listenSocket);
 	int set_port(int port);
 	int setBufLen(int buflen);
+	int set_backlog(int backlog);
 private:
 
-	int 	serverSock, _port;
+	int 	serverSock, _port, _backlog;
 
 	static void * process_client(void * args);
 
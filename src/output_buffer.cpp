@@ -0,0 +1,455 @@
+#include "output_buffer.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: output_buffer.cpp - Hold the code for the per-connection output buffer used by the servers.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: OutputBuffer::OutputBuffer()
+--			  OutputBuffer::~OutputBuffer()
+--			  int OutputBuffer::write(int socket, const char * data, int len)
+--			  int OutputBuffer::flush(int socket)
+--			  int OutputBuffer::write_zerocopy(int socket, char * data, int len, bool * pinned)
+--			  int OutputBuffer::complete_zerocopy(int socket, int * copied)
+--			  void OutputBuffer::clear()
+--			  void OutputBuffer::set_watermarks(size_t low, size_t high)
+--			  void OutputBuffer::set_default_watermarks(size_t low, size_t high)
+--			  int OutputBuffer::append(const char * data, size_t len)
+--			  void OutputBuffer::update_paused()
+--			  void OutputBuffer::release_zerocopy()
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Keeps the bytes a non-blocking send() could not take until the socket is writable again.  Not thread
+-- safe: a buffer is only used by the thread that currently owns its connection.
+----------------------------------------------------------------------------------------------------------------------*/
+
+// buffers that grew past this for a slow client give the memory back when cleared
+#define OUTPUT_KEEP_CAPACITY	4096
+
+size_t OutputBuffer::_default_low = OUTPUT_LOW_WATERMARK;
+size_t OutputBuffer::_default_high = OUTPUT_HIGH_WATERMARK;
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: OutputBuffer (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: OutputBuffer::OutputBuffer()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Creates an empty buffer using the default watermarks.  No memory is allocated until a send is short.
+----------------------------------------------------------------------------------------------------------------------*/
+OutputBuffer::OutputBuffer() : _buf(NULL), _start(0), _end(0), _capacity(0),
+	_low(_default_low), _high(_default_high), _paused(false), _zc_next(0) {}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ~OutputBuffer
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: OutputBuffer::~OutputBuffer()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Frees the buffer memory, with any zero-copy buffers still pinned: only delete a buffer whose
+-- socket is closed and has had every completion read, or that was cleared.
+----------------------------------------------------------------------------------------------------------------------*/
+OutputBuffer::~OutputBuffer(){
+	release_zerocopy();
+	free(_buf);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: write
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int OutputBuffer::write(int socket, const char * data, int len)
+--				int socket - non-blocking client socket
+--				const char * data - bytes to send
+--				int len - number of bytes
+--
+-- RETURNS:  number of bytes still pending, -1 if the socket failed
+--
+-- NOTES: Sends straight away when nothing is pending, and keeps whatever the socket did not take.  Data is
+-- never sent ahead of bytes that are already pending.
+----------------------------------------------------------------------------------------------------------------------*/
+int OutputBuffer::write(int socket, const char * data, int len){
+	int n = 0;
+	if(pending() == 0){
+		n = send(socket, data, len, MSG_NOSIGNAL);
+		if(n == -1){
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return -1;
+			}
+			n = 0;
+		}
+	}
+	if(n < len && append(data + n, len - n) < 0){
+		return -1;
+	}
+	update_paused();
+	return pending();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: flush
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int OutputBuffer::flush(int socket)
+--				int socket - non-blocking client socket
+--
+-- RETURNS:  number of bytes still pending, -1 if the socket failed
+--
+-- NOTES: Sends as much of the pending data as the socket will take.
+----------------------------------------------------------------------------------------------------------------------*/
+int OutputBuffer::flush(int socket){
+	while(pending() > 0){
+		int n = send(socket, _buf + _start, pending(), MSG_NOSIGNAL);
+		if(n == -1){
+			if(errno == EINTR){
+				continue;
+			}
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return -1;
+			}
+			break;
+		}
+		_start += n;
+	}
+	if(pending() == 0){
+		_start = _end = 0;
+	}
+	update_paused();
+	return pending();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: write_zerocopy
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int OutputBuffer::write_zerocopy(int socket, char * data, int len, bool * pinned)
+--				int socket - non-blocking client socket with SO_ZEROCOPY set
+--				char * data - malloc'd bytes to send
+--				int len - number of bytes
+--				bool * pinned - set when the buffer now belongs to this object
+--
+-- RETURNS:  number of bytes still pending, -1 if the socket failed
+--
+-- NOTES: Sends with MSG_ZEROCOPY when nothing is pending.  If the kernel took any of it the buffer is kept
+-- until complete_zerocopy() sees its completion and the caller has to use a new one.  Falls back to the
+-- copying write() when output is pending or the socket is out of option memory.
+----------------------------------------------------------------------------------------------------------------------*/
+int OutputBuffer::write_zerocopy(int socket, char * data, int len, bool * pinned){
+	*pinned = false;
+	if(pending() > 0){
+		return write(socket, data, len);
+	}
+	int n = send(socket, data, len, MSG_NOSIGNAL | MSG_ZEROCOPY);
+	if(n == -1){
+		if(errno == ENOBUFS){
+			return write(socket, data, len);
+		}
+		if(errno != EAGAIN && errno != EWOULDBLOCK){
+			return -1;
+		}
+		n = 0;
+	}
+	if(n > 0){
+		struct zc_chunk chunk = { data, _zc_next++, false };
+		_zc.push_back(chunk);
+		*pinned = true;
+	}
+	if(n < len && append(data + n, len - n) < 0){
+		return -1;
+	}
+	update_paused();
+	return pending();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: complete_zerocopy
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int OutputBuffer::complete_zerocopy(int socket, int * copied)
+--				int socket - client socket
+--				int * copied - set to how many of the completed sends the kernel copied anyway
+--
+-- RETURNS:  number of zero-copy sends completed, -1 if the socket failed
+--
+-- NOTES: Drains the socket's error queue.  Every zero-copy notification covers a range of send ids; the
+-- buffers in it are freed once every older one is done too.
+----------------------------------------------------------------------------------------------------------------------*/
+int OutputBuffer::complete_zerocopy(int socket, int * copied){
+	int done = 0;
+	*copied = 0;
+	while(!_zc.empty()){
+		char control[CMSG_SPACE(sizeof(struct sock_extended_err)) * 2];
+		struct msghdr msg;
+		memset(&msg, 0, sizeof(msg));
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+		if(recvmsg(socket, &msg, MSG_ERRQUEUE) == -1){
+			if(errno == EINTR){
+				continue;
+			}
+			if(errno != EAGAIN && errno != EWOULDBLOCK){
+				return -1;
+			}
+			break;
+		}
+		for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)){
+			if(!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+				(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))){
+				continue;
+			}
+			struct sock_extended_err* err = (struct sock_extended_err*) CMSG_DATA(cm);
+			if(err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY){
+				continue;
+			}
+			// the notification covers ids ee_info..ee_data inclusive, which may wrap
+			uint32_t lo = err->ee_info, hi = err->ee_data;
+			for(size_t i = 0; i < _zc.size(); i++){
+				if(_zc[i].id - lo <= hi - lo && !_zc[i].done){
+					_zc[i].done = true;
+					++done;
+					if(err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED){
+						++*copied;
+					}
+				}
+			}
+		}
+		while(!_zc.empty() && _zc.front().done){
+			free(_zc.front().data);
+			_zc.pop_front();
+		}
+	}
+	return done;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: clear
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void OutputBuffer::clear()
+--
+-- RETURNS:  void
+--
+-- NOTES: Drops pending data when the connection closes, and resets the watermarks for the next connection
+-- that uses the buffer.  Pinned zero-copy buffers are not freed here: until their completions are read the
+-- socket may still be sending from them, and a freed one could be handed out by malloc and overwritten.  A
+-- server that sends with MSG_ZEROCOPY takes the buffer away from a closing connection that still has sends
+-- pinned and keeps the socket open until they complete; any still left here are forgotten, never freed.
+----------------------------------------------------------------------------------------------------------------------*/
+void OutputBuffer::clear(){
+	_zc.clear();
+	_zc_next = 0;
+	_start = _end = 0;
+	_paused = false;
+	_low = _default_low;
+	_high = _default_high;
+	if(_capacity > OUTPUT_KEEP_CAPACITY){
+		free(_buf);
+		_buf = NULL;
+		_capacity = 0;
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_watermarks
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void OutputBuffer::set_watermarks(size_t low, size_t high)
+--				size_t low - pending bytes at which a paused connection resumes
+--				size_t high - pending bytes at which the connection is paused
+--
+-- RETURNS:  void
+--
+-- NOTES: Sets the watermarks for this connection only.
+----------------------------------------------------------------------------------------------------------------------*/
+void OutputBuffer::set_watermarks(size_t low, size_t high){
+	_low = low;
+	_high = high;
+	update_paused();
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_default_watermarks
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void OutputBuffer::set_default_watermarks(size_t low, size_t high)
+--				size_t low - pending bytes at which a paused connection resumes
+--				size_t high - pending bytes at which the connection is paused
+--
+-- RETURNS:  void
+--
+-- NOTES: Sets the watermarks new connections start with.  Call before the server starts.
+----------------------------------------------------------------------------------------------------------------------*/
+void OutputBuffer::set_default_watermarks(size_t low, size_t high){
+	_default_low = low;
+	_default_high = high;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: append
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int OutputBuffer::append(const char * data, size_t len)
+--				const char * data - bytes to keep
+--				size_t len - number of bytes
+--
+-- RETURNS:  0 on success, -1 if memory ran out
+--
+-- NOTES: Copies bytes to the end of the buffer, moving pending data to the front or growing as needed.
+----------------------------------------------------------------------------------------------------------------------*/
+int OutputBuffer::append(const char * data, size_t len){
+	if(_end + len > _capacity){
+		if(pending() + len <= _capacity){
+			memmove(_buf, _buf + _start, pending());
+		} else {
+			size_t capacity = _capacity ? _capacity : 1024;
+			while(capacity < pending() + len){
+				capacity *= 2;
+			}
+			char * buf = (char *) malloc(capacity);
+			if(buf == NULL){
+				fprintf(stderr, "out of memory for output buffer\n");
+				return -1;
+			}
+			memcpy(buf, _buf + _start, pending());
+			free(_buf);
+			_buf = buf;
+			_capacity = capacity;
+		}
+		_end -= _start;
+		_start = 0;
+	}
+	memcpy(_buf + _end, data, len);
+	_end += len;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: update_paused
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void OutputBuffer::update_paused()
+--
+-- RETURNS:  void
+--
+-- NOTES: Pauses at the high watermark and resumes at the low one, so a backed-up connection does not flap.
+----------------------------------------------------------------------------------------------------------------------*/
+void OutputBuffer::update_paused(){
+	if(pending() >= _high){
+		_paused = true;
+	} else if(pending() <= _low){
+		_paused = false;
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: release_zerocopy
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void OutputBuffer::release_zerocopy()
+--
+-- RETURNS:  void
+--
+-- NOTES: Frees every pinned buffer and restarts the send ids, which a new socket counts from zero.
+----------------------------------------------------------------------------------------------------------------------*/
+void OutputBuffer::release_zerocopy(){
+	for(size_t i = 0; i < _zc.size(); i++){
+		free(_zc[i].data);
+	}
+	_zc.clear();
+	_zc_next = 0;
+}
@@ -0,0 +1,67 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <stdint.h>
+#include <deque>
+
+#define OUTPUT_LOW_WATERMARK	16384
+#define OUTPUT_HIGH_WATERMARK	65536
+
+/**
+per-connection output buffer.  holds whatever a non-blocking send() could not
+take so a short write never drops part of an echo.  once the pending bytes
+reach the high watermark the connection is paused (the server stops reading
+it) until a flush brings them back down to the low watermark.
+
+buffers sent with MSG_ZEROCOPY are kept here, pinned, until the kernel
+reports on the socket's error queue that it is done with them.
+*/
+class OutputBuffer {
+
+public:
+	OutputBuffer();
+	~OutputBuffer();
+	OutputBuffer(const OutputBuffer&) = delete;
+	OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+	int write(int socket, const char * data, int len);
+	int flush(int socket);
+	int write_zerocopy(int socket, char * data, int len, bool * pinned);
+	int complete_zerocopy(int socket, int * copied);
+	size_t pinned() const { return _zc.size(); }
+	void clear();
+	size_t pending() const { return _end - _start; }
+	bool paused() const { return _paused; }
+	void set_watermarks(size_t low, size_t high);
+	static void set_default_watermarks(size_t low, size_t high);
+private:
+	int append(const char * data, size_t len);
+	void update_paused();
+	void release_zerocopy();
+
+	// a buffer handed to a MSG_ZEROCOPY send, id is the socket's zero-copy send counter for it
+	struct zc_chunk {
+		char * data;
+		uint32_t id;
+		bool done;
+	};
+
+	char * _buf;
+	size_t _start, _end, _capacity;
+	size_t _low, _high;
+	bool _paused;
+	std::deque<struct zc_chunk> _zc;
+	uint32_t _zc_next;
+
+	static size_t _default_low, _default_high;
+};
+
+#endif
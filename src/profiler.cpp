@@ -0,0 +1,377 @@
+#include "profiler.h"
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <ucontext.h>
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: profiler.cpp - Hold the code for the SIGPROF sampling profiler.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: Profiler::Profiler()
+--			  Profiler* Profiler::Instance()
+--			  int Profiler::start(int hz)
+--			  void Profiler::handler(int signum, siginfo_t* info, void* context)
+--			  void Profiler::record(uintptr_t pc, uintptr_t fp, uintptr_t sp)
+--			  const std::string& Profiler::symbol(uintptr_t pc, std::map<uintptr_t, std::string>& names)
+--			  void Profiler::dump(std::string& folded)
+--			  int Profiler::dump_file(const char* path)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Dumps are folded stacks, "role;outermost;...;innermost count" per line, the input of flamegraph.pl and
+-- speedscope.  Frames are named with dladdr, which only sees exported symbols: the server is linked with
+-- -rdynamic, and anything still unnamed is written as module+offset for addr2line.  Stacks only go past the
+-- first frame through code built with frame pointers; make profile builds the server that way.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Profiler (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Profiler::Profiler()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Profiling is off, and nothing is allocated, until it is started.
+----------------------------------------------------------------------------------------------------------------------*/
+Profiler::Profiler() : _samples(NULL), _next(0), _dumpRequested(false), _hz(0)
+{
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Profiler* Profiler::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates the instance of the profiler.  It is constructed before the timer starts, so the signal
+-- handler only ever finds it built.
+----------------------------------------------------------------------------------------------------------------------*/
+Profiler* Profiler::Instance()
+{
+	static Profiler m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: start
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Profiler::start(int hz)
+--					int hz - samples per second of CPU time used by the whole process
+--
+-- RETURNS:  0 on success, -1 if the rate is out of range or the ring, the handler or the timer could not be set up
+--
+-- NOTES: Must be called before the server starts its threads.  ITIMER_PROF counts the CPU time of every thread,
+-- so an idle server takes no samples and a busy one takes hz per busy core.  The handler restarts the calls it
+-- interrupts where it can; the ones that return EINTR anyway (epoll_wait, select) are retried by the loops.
+----------------------------------------------------------------------------------------------------------------------*/
+int Profiler::start(int hz){
+#ifndef PROFILE_HAVE_FP
+	fprintf(stderr, "profiling is not supported on this architecture\n");
+	return -1;
+#endif
+	if(hz <= 0 || hz > PROFILE_MAX_HZ){
+		fprintf(stderr, "profile rate must be 1 to %d Hz\n", PROFILE_MAX_HZ);
+		return -1;
+	}
+	if(_samples == NULL){
+		_samples = new (std::nothrow) profile_sample[PROFILE_SAMPLES]();
+		if(_samples == NULL){
+			fprintf(stderr, "out of memory for profile samples\n");
+			return -1;
+		}
+	}
+
+	struct sigaction sa;
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = handler;
+	sa.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&sa.sa_mask);
+	if(sigaction(SIGPROF, &sa, NULL) < 0){
+		perror("sigaction SIGPROF");
+		return -1;
+	}
+
+	struct itimerval timer;
+	long interval = 1000000 / hz;
+	timer.it_interval.tv_sec = interval / 1000000;
+	timer.it_interval.tv_usec = interval % 1000000;
+	timer.it_value = timer.it_interval;
+	if(setitimer(ITIMER_PROF, &timer, NULL) < 0){
+		perror("setitimer");
+		return -1;
+	}
+	_hz = hz;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: handler
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Profiler::handler(int signum, siginfo_t* info, void* context)
+--					int signum      - SIGPROF
+--					siginfo_t* info - unused
+--					void* context   - registers of the interrupted thread
+--
+-- RETURNS:  void
+--
+-- NOTES: Takes the program counter, frame pointer and stack pointer out of the interrupted context.
+----------------------------------------------------------------------------------------------------------------------*/
+void Profiler::handler(int signum, siginfo_t* info, void* context){
+#ifdef PROFILE_HAVE_FP
+	ucontext_t* uc = (ucontext_t*) context;
+#if defined(__x86_64__)
+	Instance()->record(uc->uc_mcontext.gregs[REG_RIP], uc->uc_mcontext.gregs[REG_RBP], uc->uc_mcontext.gregs[REG_RSP]);
+#else
+	Instance()->record(uc->uc_mcontext.pc, uc->uc_mcontext.regs[29], uc->uc_mcontext.sp);
+#endif
+#endif
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: record
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Profiler::record(uintptr_t pc, uintptr_t fp, uintptr_t sp)
+--					uintptr_t pc - where the thread was interrupted
+--					uintptr_t fp - its frame pointer
+--					uintptr_t sp - its stack pointer
+--
+-- RETURNS:  void
+--
+-- NOTES: Runs in the signal handler: no locks, no allocation, no calls that are not async-signal-safe.  Each
+-- frame record holds the caller's frame pointer and the return address into it.  A frame pointer is only
+-- followed while it points into the thread's own stack, above the stack pointer and higher than the last one,
+-- so code built without frame pointers, whose register holds anything, ends the walk instead of faulting.
+-- A thread whose stack is unknown gets the interrupted frame only.
+----------------------------------------------------------------------------------------------------------------------*/
+void Profiler::record(uintptr_t pc, uintptr_t fp, uintptr_t sp){
+	uintptr_t lo, hi;
+	thread_stats* t = ThreadStats::current();
+	uint64_t n = _next.fetch_add(1, std::memory_order_relaxed);
+	struct profile_sample* s = &_samples[n % PROFILE_SAMPLES];
+
+	s->seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s->role = t != NULL ? t->role.load(std::memory_order_relaxed) : NULL;
+	int depth = 0;
+	s->pc[depth++] = pc;
+
+	ThreadStats::stack(lo, hi);
+	if(sp >= lo && sp < hi){
+		while(depth < PROFILE_DEPTH && fp >= sp && fp < hi - 2 * sizeof(uintptr_t) && fp % sizeof(uintptr_t) == 0){
+			uintptr_t* frame = (uintptr_t*) fp;
+			if(frame[1] == 0){
+				break;
+			}
+			s->pc[depth++] = frame[1];
+			if(frame[0] <= fp){
+				break;
+			}
+			fp = frame[0];
+		}
+	}
+	s->depth = depth;
+	s->seq.store(n + 1, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: symbol
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: const std::string& Profiler::symbol(uintptr_t pc, std::map<uintptr_t, std::string>& names)
+--					uintptr_t pc                              - address inside the function
+--					std::map<uintptr_t, std::string>& names - names already looked up in this dump
+--
+-- RETURNS:  the demangled function name without its parameter list, module+offset if it has no exported
+--			 symbol, or the bare address
+--
+-- NOTES: Parameters are dropped to keep the folded lines short; overloads share a frame.
+----------------------------------------------------------------------------------------------------------------------*/
+const std::string& Profiler::symbol(uintptr_t pc, std::map<uintptr_t, std::string>& names){
+	std::map<uintptr_t, std::string>::iterator it = names.find(pc);
+	if(it != names.end()){
+		return it->second;
+	}
+	std::string name;
+	char buf[256];
+	Dl_info info;
+	if(dladdr((void*) pc, &info) != 0 && info.dli_sname != NULL){
+		int status;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+		name = status == 0 && demangled != NULL ? demangled : info.dli_sname;
+		free(demangled);
+		// cut the parameter list, and a const after it, from the end
+		size_t end = name.rfind(')');
+		if(end != std::string::npos && name.find_first_not_of(" const", end + 1) == std::string::npos){
+			int depth = 0;
+			for(size_t i = end + 1; i-- > 0;){
+				depth += name[i] == ')' ? 1 : name[i] == '(' ? -1 : 0;
+				if(depth == 0){
+					name.erase(i);
+					break;
+				}
+			}
+		}
+	} else if(info.dli_fname != NULL){
+		const char* module = strrchr(info.dli_fname, '/');
+		snprintf(buf, sizeof(buf), "%s+0x%lx", module != NULL ? module + 1 : info.dli_fname,
+			(unsigned long)(pc - (uintptr_t) info.dli_fbase));
+		name = buf;
+	} else {
+		snprintf(buf, sizeof(buf), "0x%lx", (unsigned long) pc);
+		name = buf;
+	}
+	return names[pc] = name;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: dump
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Profiler::dump(std::string& folded)
+--					std::string& folded - receives one line per distinct stack, with the times it was sampled
+--
+-- RETURNS:  void
+--
+-- NOTES: Covers the last PROFILE_SAMPLES samples and leaves them in place, so every dump is the recent
+-- profile.  Reads the ring while the handler keeps writing it; a stack overwritten while it was copied is left
+-- out.  Return addresses are looked up one byte back, inside the call rather than after it.
+----------------------------------------------------------------------------------------------------------------------*/
+void Profiler::dump(std::string& folded){
+	std::map<std::string, long> stacks;
+	std::map<uintptr_t, std::string> names;
+	uintptr_t pc[PROFILE_DEPTH];
+	char count[32];
+
+	folded.clear();
+	if(_samples == NULL){
+		return;
+	}
+	uint64_t next = _next.load(std::memory_order_acquire);
+	uint64_t first = next > PROFILE_SAMPLES ? next - PROFILE_SAMPLES : 0;
+	for(uint64_t k = first; k < next; k++){
+		struct profile_sample* s = &_samples[k % PROFILE_SAMPLES];
+		if(s->seq.load(std::memory_order_acquire) != k + 1){
+			continue;
+		}
+		const char* role = s->role;
+		int depth = s->depth < PROFILE_DEPTH ? s->depth : PROFILE_DEPTH;
+		memcpy(pc, s->pc, depth * sizeof(uintptr_t));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(s->seq.load(std::memory_order_relaxed) != k + 1){
+			continue;
+		}
+
+		std::string stack = role != NULL ? role : "other";
+		for(int d = depth - 1; d >= 0; d--){
+			stack += ';';
+			stack += symbol(d == 0 ? pc[d] : pc[d] - 1, names);
+		}
+		stacks[stack]++;
+	}
+	for(std::map<std::string, long>::iterator it = stacks.begin(); it != stacks.end(); ++it){
+		snprintf(count, sizeof(count), " %ld\n", it->second);
+		folded += it->first;
+		folded += count;
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: dump_file
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Profiler::dump_file(const char* path)
+--					const char* path - file to write, replaced if it exists
+--
+-- RETURNS:  0 on success, -1 on error
+--
+-- NOTES: Run by the stats thread after SIGUSR2, never by the signal handler itself.
+----------------------------------------------------------------------------------------------------------------------*/
+int Profiler::dump_file(const char* path){
+	std::string folded;
+	dump(folded);
+	FILE* f = fopen(path, "w");
+	if(f == NULL){
+		perror("profile file");
+		return -1;
+	}
+	size_t written = fwrite(folded.data(), 1, folded.size(), f);
+	if(fclose(f) != 0 || written != folded.size()){
+		perror("profile file");
+		return -1;
+	}
+	uint64_t taken = _next.load(std::memory_order_relaxed);
+	fprintf(stderr, "profile of the last %lu samples at %d Hz written to %s\n",
+		(unsigned long)(taken < PROFILE_SAMPLES ? taken : PROFILE_SAMPLES), _hz, path);
+	return 0;
+}
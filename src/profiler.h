@@ -0,0 +1,67 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "thread_stats.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#if defined(__x86_64__) || defined(__aarch64__)
+#define PROFILE_HAVE_FP 1			// frame records are {caller's frame pointer, return address} on both
+#endif
+
+#define PROFILE_SAMPLES 16384		// stacks kept, older ones are overwritten
+#define PROFILE_DEPTH 32			// frames kept per stack, from the interrupted one up
+#define PROFILE_MAX_HZ 1000
+#define PROFILE_FILE "test/profile.folded"
+
+/**
+one stack taken by the SIGPROF handler.  seq is 0 while the handler writes
+it and the sample's number plus one after, so a dump can tell a finished
+stack from one being overwritten under it.
+*/
+struct profile_sample {
+	std::atomic<uint64_t> seq;
+	const char* role;			// role of the interrupted thread, NULL if it never said
+	int depth;
+	uintptr_t pc[PROFILE_DEPTH];
+};
+
+/**
+samples the server's stacks at a fixed rate of CPU time.  ITIMER_PROF sends
+SIGPROF to the thread that is running when the time is up; the handler walks
+its frame pointers, inside the stack bounds the thread recorded with
+ThreadStats::set_role, into a ring allocated when profiling starts.  dumps
+fold the ring into flamegraph input, one line per stack, names looked up then.
+*/
+class Profiler {
+
+public:
+	static Profiler* Instance();
+
+	int start(int hz);
+	bool enabled() { return _samples != NULL; }
+	void dump(std::string& folded);
+	int dump_file(const char* path);
+	void request_dump() { _dumpRequested.store(true, std::memory_order_relaxed); }
+	bool dump_requested() { return _dumpRequested.exchange(false, std::memory_order_relaxed); }
+private:
+	Profiler();
+	static void handler(int signum, siginfo_t* info, void* context);
+	void record(uintptr_t pc, uintptr_t fp, uintptr_t sp);
+	static const std::string& symbol(uintptr_t pc, std::map<uintptr_t, std::string>& names);
+
+	struct profile_sample* _samples;
+	std::atomic<uint64_t> _next;		// number of the next sample, never wraps
+	std::atomic<bool> _dumpRequested;
+	int _hz;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "blocking_queue.h"
+#include "mpmc_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: queue_bench.cpp - Microbenchmark of the fd hand-off queues.
+--
+-- PROGRAM: queue_bench
+--
+-- FUNCTIONS: void * producer(void * args)
+--			  void * consumer(void * args)
+--			  double run_bench(int threads, long items)
+--			  int main(int argc, char **argv)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Pushes the same number of ints through blocking_queue and mpmc_queue with N producer and N consumer
+-- threads, the way the epoll dispatcher and its workers use fd_queue, and prints throughput for each.
+--	./queue_bench [itemsPerRun]
+----------------------------------------------------------------------------------------------------------------------*/
+
+#define QUEUE_SIZE 1024
+
+template<typename Q>
+struct bench_args {
+	Q* q;
+	long items;
+	std::chrono::milliseconds timeout;
+};
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: producer
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * producer(void * args)
+--				void * args - bench_args for this thread
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Pushes its share of items, retrying on timeout.
+----------------------------------------------------------------------------------------------------------------------*/
+template<typename Q>
+void * producer(void * args)
+{
+	bench_args<Q>* a = (bench_args<Q>*) args;
+	for(long i = 0; i < a->items; ++i){
+		while(!a->q->push((int)i, a->timeout));
+	}
+	return (void*)0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: consumer
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * consumer(void * args)
+--				void * args - bench_args for this thread
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Pops its share of items, retrying on timeout.
+----------------------------------------------------------------------------------------------------------------------*/
+template<typename Q>
+void * consumer(void * args)
+{
+	bench_args<Q>* a = (bench_args<Q>*) args;
+	int item;
+	for(long i = 0; i < a->items; ++i){
+		while(!a->q->pop(item, a->timeout));
+	}
+	return (void*)0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: run_bench
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: double run_bench(int threads, long items)
+--				int threads - number of producers, and of consumers
+--				long items  - total number of items to pass through the queue
+--
+-- RETURNS:  elapsed wall-clock seconds
+--
+-- NOTES: Runs one producer/consumer round against a fresh queue of type Q.  The queue lives on the stack: its
+-- cells are allocated by the queue, and the object itself is a few cache lines, which new would not align
+-- under C++11.
+----------------------------------------------------------------------------------------------------------------------*/
+template<typename Q>
+double run_bench(int threads, long items)
+{
+	Q q(QUEUE_SIZE);
+	pthread_t tids[threads * 2];
+	bench_args<Q> args;
+	struct timespec start, end;
+
+	args.q = &q;
+	args.items = items / threads;
+	args.timeout = std::chrono::milliseconds(100);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(int i = 0; i < threads; ++i){
+		pthread_create(&tids[i], NULL, consumer<Q>, (void*)&args);
+		pthread_create(&tids[threads + i], NULL, producer<Q>, (void*)&args);
+	}
+	for(int i = 0; i < threads * 2; ++i){
+		pthread_join(tids[i], NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: main (queue_bench)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int main(int argc, char **argv)
+--		       int argc - number of cmd-line arguments
+--		       char **argv - double pointer to array of arguments
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Runs both queues at 1, 4, 16 and 64 producer/consumer pairs and prints the results as a table.
+----------------------------------------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	const int thread_counts[] = {1, 4, 16, 64};
+	long items = 1 << 20;
+	if(argc > 1){
+		items = atol(argv[1]);
+	}
+
+	printf("%-8s %18s %18s %8s\n", "threads", "blocking_queue", "mpmc_queue", "speedup");
+	for(unsigned int i = 0; i < sizeof(thread_counts) / sizeof(thread_counts[0]); ++i){
+		int threads = thread_counts[i];
+		long n = items - items % threads;
+		double blocking = run_bench< blocking_queue<int> >(threads, n);
+		double lockfree = run_bench< mpmc_queue<int> >(threads, n);
+		printf("%-8d %12.2f Mop/s %12.2f Mop/s %7.2fx\n", threads,
+			n / blocking / 1e6, n / lockfree / 1e6, blocking / lockfree);
+	}
+	return 0;
+}
@@ -0,0 +1,577 @@
+#include "reactor_server.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: reactor_server.cpp - Hold the code for the multi-reactor epoll server used by the echo client.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: ReactorServer* ReactorServer::Instance()
+--			  int ReactorServer::run()
+--			  int ReactorServer::create_socket()
+--			  int ReactorServer::bind_socket()
+--			  void ReactorServer::listen_for_clients()
+--			  int ReactorServer::accept_client()
+--			  int ReactorServer::send_msgs(int socket, char * data, int len)
+--			  int ReactorServer::recv_msgs(int socket, char * bp)
+--			  int ReactorServer::set_sock_option(int listenSocket)
+--			  int ReactorServer::interest(OutputBuffer* out)
+--			  void * ReactorServer::process_reactor(void * args)
+--			  int ReactorServer::set_port(int port)
+--			  int ReactorServer::set_num_threads(int num)
+--			  int ReactorServer::setBufLen(int buflen)
+--			  int ReactorServer::set_backlog(int backlog)
+--
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Multi-reactor epoll server.  Unlike EpollServer there is no shared dispatcher or fd queue: every reactor
+-- thread owns an epoll instance and the connections registered on it.  The main thread only accepts and hands
+-- each new socket to the next reactor in round-robin order.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: ReactorServer* ReactorServer::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates an instance of reactor server.
+----------------------------------------------------------------------------------------------------------------------*/
+ReactorServer* ReactorServer::Instance()
+{
+	static ReactorServer m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: run
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::run()
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Main reactor server function.  Starts one reactor per worker thread and then accepts connections
+-- for them.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::run() {
+	if(_numThreads < 1){
+		_numThreads = 1;
+	}
+	reactors.resize(_numThreads);
+	next_reactor = 0;
+
+	for(int i = 0; i < _numThreads; i++)
+	{
+		reactors[i].id = i;
+		reactors[i].epoll_fd = epoll_create(MAXCLIENTS / _numThreads + 1);
+		if (reactors[i].epoll_fd == -1){
+			fprintf(stderr,"epoll_create\n");
+			exit(1);
+		}
+	}
+	for(int i = 0; i < _numThreads; i++)
+	{
+		pthread_create(&reactors[i].tid, NULL, process_reactor, (void*)&reactors[i]);
+	}
+
+	serverSock = create_socket();
+	serverSock = bind_socket();
+	serverSock = set_sock_option(serverSock);
+	listen_for_clients();
+
+	while(accept_client() >= 0);
+
+	close(serverSock);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: create_socket
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::create_socket()
+--
+-- RETURNS:  Socket Descriptor
+--
+-- NOTES: Creates a socket and returns the socket descriptor on successful creation.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::create_socket()
+{
+	int sd;
+	// Create the socket
+	if ((sd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+	{
+		perror("Cannot create socket");
+	}
+	return sd;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: bind_socket
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::bind_socket()
+--
+-- RETURNS:  Server Socket Descriptor
+--
+-- NOTES: Function that binds an address to the server socket and returns the server socket.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::bind_socket()
+{
+	struct	sockaddr_in server;
+
+	// Bind an address to the socket
+	bzero((char *)&server, sizeof(struct sockaddr_in));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(_port);
+	server.sin_addr.s_addr = htonl(INADDR_ANY); // Accept connections from any client
+
+	if (bind(serverSock, (struct sockaddr *)&server, sizeof(server)) == -1)
+	{
+		perror("Can't bind name to socket");
+		exit(1);
+	}
+	return serverSock;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: listen_for_clients
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ReactorServer::listen_for_clients()
+--
+-- RETURNS:  void
+--
+-- NOTES: Sets the number of clients the server will handle requests to.
+----------------------------------------------------------------------------------------------------------------------*/
+void ReactorServer::listen_for_clients()
+{
+	// Listen for connections
+
+	listen(serverSock, _backlog);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: accept_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::accept_client()
+--
+-- RETURNS:  New Socket Descriptor, 0 if the accept was interrupted, -1 on error
+--
+-- NOTES: Function that blocks until a client connection request comes in.  It will add the client to the list
+-- and register it with the next reactor in round-robin order.  The connection gets TCP_NODELAY.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::accept_client()
+{
+	struct	sockaddr_in client;
+	unsigned int client_len = sizeof(client);
+	struct epoll_event event;
+	int sServerSock;
+	if ((sServerSock = accept (serverSock, (struct sockaddr *)&client, &client_len)) == -1){
+		if (errno == EINTR || errno == ECONNABORTED) {
+			return 0;
+		}
+		LOG_WARN("Can't accept client: %s", strerror(errno));
+		return -1;
+	}
+
+	// Make the fd_new non-blocking
+	if (fcntl (sServerSock, F_SETFL, O_NONBLOCK | fcntl(sServerSock, F_GETFL, 0)) == -1) {
+		fprintf(stderr,"fcntl\n");
+	}
+	int nodelay = 1;
+	if (setsockopt (sServerSock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+		perror("setsockopt TCP_NODELAY");
+	}
+
+	// the client must be in the list before its reactor can see it
+	ClientData::Instance()->addClient(sServerSock, inet_ntoa(client.sin_addr),client.sin_port );
+	ClientData::Instance()->recordAccept(1);
+
+	struct reactor * r = &reactors[next_reactor++ % reactors.size()];
+	event.events = EPOLLIN | EPOLLERR | EPOLLHUP;
+	event.data.fd = sServerSock;
+	if (epoll_ctl (r->epoll_fd, EPOLL_CTL_ADD, sServerSock, &event) == -1) {
+		fprintf(stderr,"epoll_ctl\n");
+		ClientData::Instance()->removeClient(sServerSock);
+		close(sServerSock);
+		return 0;
+	}
+
+	return sServerSock;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: send_msgs
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::send_msgs(int socket, char * data, int len)
+--					  int socket - client socket
+--					  char * data - data that the server will send back to the client
+--					  int len - number of bytes to send
+--
+-- RETURNS:  number of bytes left pending in the client's output buffer, -1 if the socket failed
+--
+-- NOTES: Send Messages function used by the reactor server.  Whatever the socket does not take right away is
+-- kept in the client's output buffer.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::send_msgs(int socket, char * data, int len)
+{
+	OutputBuffer* out = ClientData::Instance()->output(socket);
+	if (out == NULL)
+		return -1;
+	return out->write(socket, data, len);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recv_msgs
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::recv_msgs(int socket, char * bp)
+--					 int socket - client socket
+--					 char * bp - data that the server will receive from the client
+--
+-- RETURNS:  number of bytes read, -1 if the client was closed
+--
+-- NOTES: Receive Messages function used by the reactor server.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::recv_msgs(int socket, char * bp)
+{
+	int n, bytes_to_read = _buflen;
+	while ((n = recv (socket, bp, bytes_to_read, 0)) < bytes_to_read)
+	{
+		if(n == -1){
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			LOG_WARN("recv error %d on socket %d, %d bytes to read", errno, socket, bytes_to_read);
+			ClientData::Instance()->removeClient(socket);
+			close(socket);
+			return -1;
+		} else if (n == 0){
+			LOG_INFO("socket was gracefully closed by other side %d", socket);
+			ClientData::Instance()->removeClient(socket);
+			close(socket);
+			return -1;
+		}
+		bp += n;
+		bytes_to_read -= n;
+	}
+	if(n > 0){
+		bytes_to_read -= n;
+	}
+
+	return _buflen - bytes_to_read;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_sock_option
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::set_sock_option(int listenSocket)
+--					       int listenSocket - listening socket
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Function that sets the listening socket options.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::set_sock_option(int listenSocket)
+{
+	// Reuse address set
+	int value = 1;
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	// Set buffer length to send or receive to _buflen.
+	value = _buflen;
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	return listenSocket;
+
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: interest
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::interest(OutputBuffer* out)
+--					OutputBuffer* out - output buffer of the connection
+--
+-- RETURNS:  epoll events the connection should be registered for
+--
+-- NOTES: EPOLLOUT only while output is pending, EPOLLIN only while the output is under its high watermark.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::interest(OutputBuffer* out)
+{
+	int events = EPOLLERR | EPOLLHUP;
+	if (!out->paused())
+		events |= EPOLLIN;
+	if (out->pending() > 0)
+		events |= EPOLLOUT;
+	return events;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_reactor
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * ReactorServer::process_reactor(void * args)
+--					void * args - the struct reactor this thread runs
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Reactor thread.  Waits on its own epoll instance and echoes every message from the connections
+-- registered with it.  Connections are level-triggered since only this thread ever reads them; the
+-- registration is only changed when the connection starts or stops waiting on output.  Everything between two
+-- epoll_waits counts as busy time.
+----------------------------------------------------------------------------------------------------------------------*/
+void * ReactorServer::process_reactor(void * args)
+{
+	struct reactor * r = (struct reactor *) args;
+	struct epoll_event events[REACTOR_EVENTS], event;
+	OutputBuffer* out;
+	int nready, n, before;
+
+	ReactorServer* mServer = ReactorServer::Instance();
+	char buf[mServer->_buflen];
+	thread_stats* stats = ThreadStats::local();
+	uint64_t busy_since = 0;
+	ThreadStats::set_role("reactor", true);
+	while(1){
+		if(busy_since != 0){
+			stat_add(stats->busy_ns, stat_now_ns() - busy_since);
+		}
+		nready = epoll_wait (r->epoll_fd, events, REACTOR_EVENTS, -1);
+		busy_since = stat_now_ns();
+		ThreadStats::tick(busy_since);
+		for (int i = 0; i < nready; i++){
+			int sock = events[i].data.fd;
+			// Case 1: Error condition
+			if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+				ClientData::Instance()->removeClient(sock);
+				close(sock);
+				continue;
+			}
+
+			out = ClientData::Instance()->output(sock);
+			if(out == NULL){
+				continue;
+			}
+			before = mServer->interest(out);
+
+			// Case 2: Socket has room for pending output
+			if((events[i].events & EPOLLOUT) && out->flush(sock) < 0){
+				ClientData::Instance()->removeClient(sock);
+				close(sock);
+				continue;
+			}
+
+			// Case 3: One of the sockets has read data
+			if((events[i].events & EPOLLIN) && !out->paused()){
+				if((n = mServer->recv_msgs(sock, buf)) < 0){
+					continue;
+				}
+				if(n > 0){
+					ClientData::Instance()->setRtt(sock);
+					if(mServer->send_msgs(sock, buf, n) < 0){
+						ClientData::Instance()->removeClient(sock);
+						close(sock);
+						continue;
+					}
+					ClientData::Instance()->recordData(sock, n);
+				}
+			}
+
+			if(mServer->interest(out) != before){
+				event.events = mServer->interest(out);
+				event.data.fd = sock;
+				if (epoll_ctl (r->epoll_fd, EPOLL_CTL_MOD, sock, &event) == -1) {
+					fprintf(stderr,"epoll_ctl\n");
+				}
+			}
+		}
+	}
+	return (void*)0;
+
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_port
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::set_port(int port)
+--					int port - server port specified
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets server port when starting the server.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::set_port(int port){
+	_port = port;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_num_threads
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::set_num_threads(int num)
+--					int num - number of reactor threads server should use
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets the number of reactors (one epoll instance and thread each).
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::set_num_threads(int num){
+	_numThreads=num;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setBufLen
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::setBufLen(int buflen)
+--					int buflen - buffer length
+--
+-- RETURNS:  N/A
+--
+-- NOTES: sets buffer length for recv functions
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::setBufLen(int buflen){
+	_buflen = buflen;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_backlog
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ReactorServer::set_backlog(int backlog)
+--					int backlog - length of the listen queue
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets how many pending connections the listen socket queues.  The kernel caps it at somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int ReactorServer::set_backlog(int backlog){
+	_backlog = backlog;
+	return 1;
+}
@@ -0,0 +1,74 @@
+#ifndef REACTOR_SERVER_H
+#define REACTOR_SERVER_H
+
+#include "client_data.h"
+#include "output_buffer.h"
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <assert.h>
+#include <fcntl.h>
+
+
+#define BUFLEN 255
+#define TCP_PORT 7000
+#define MAXCLIENTS 100000
+#define REACTOR_EVENTS 1024
+
+/**
+one reactor per thread.  each reactor owns its own epoll instance and every
+connection registered with it, and does its own recv/send.
+*/
+struct reactor {
+	pthread_t tid;
+	int epoll_fd;
+	int id;
+};
+
+
+class ReactorServer {
+
+public:
+	static ReactorServer* Instance();
+
+
+	int run();
+	int create_socket();
+	int bind_socket();
+	void listen_for_clients();
+	int accept_client();
+	int send_msgs(int socket, char * data, int len);
+	int recv_msgs(int socket, char * bp);
+	int set_sock_option(int listenSocket);
+	int set_port(int port);
+	int set_num_threads(int num);
+	int setBufLen(int buflen);
+	int set_backlog(int backlog);
+	int _buflen;
+private:
+
+	int 	serverSock, _port, _backlog, _numThreads;
+	static void * process_reactor(void * args);
+	int interest(OutputBuffer* out);
+
+	std::vector<struct reactor> reactors;
+	unsigned int next_reactor;
+};
+
+#endif
+
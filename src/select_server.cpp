@@ -12,13 +12,17 @@
 --			  int SelectServer::bind_socket()
 --			  void SelectServer::listen_for_clients()
 --			  int SelectServer::accept_client()
---			  void SelectServer::send_msgs(int socket, char * data)
+--			  int SelectServer::send_msgs(int socket, char * data, int len)
 --			  int SelectServer::recv_msgs(int socket, char * bp)
 --			  int SelectServer::set_sock_option(int listenSocket)
+--			  int SelectServer::close_client(int socket)
+--			  void SelectServer::update_interest(int socket, OutputBuffer* out)
 
 --			  int SelectServer::set_port(int port)
 --			  int SelectServer::set_num_threads(int num);
 --			  int SelectServer::setBufLen(int buflen)
+--			  int SelectServer::set_backlog(int backlog)
+--			  void SelectServer::queue_stats(stats_snapshot& snap, bool reset)
 --			  
 --
 -- DATE: 2014/02/21
@@ -104,6 +108,7 @@ int SelectServer::run()
 	
 	
 	printf("fdset:%d\n",FD_SETSIZE);
+	ClientData::Instance()->setQueueProbe(queue_stats);
 	serverSock = create_socket();
 	serverSock = bind_socket();
 	serverSock = set_sock_option(serverSock);
@@ -115,10 +120,18 @@ int SelectServer::run()
 		client[i] = -1;   
 	}
 	FD_ZERO(&allset);
+	FD_ZERO(&allwset);
    	FD_SET(serverSock, &allset);	
+	ThreadStats::set_role("select");
 	while(true){
 		rset = allset;
-		nready = select ( maxfd + 1, &rset, NULL, NULL, NULL);
+		wset = allwset;
+		nready = select ( maxfd + 1, &rset, &wset, NULL, NULL);
+		ThreadStats::tick(stat_now_ns());
+		if (nready < 0) {
+			//interrupted, e.g. by a profiler tick: the sets were left as they were, not cleared
+			continue;
+		}
 		if (FD_ISSET(serverSock, &rset)) {
 			//new connection
 
@@ -133,7 +146,7 @@ int SelectServer::run()
 	    			}
 			}
 			if (i == FD_SETSIZE){
-				printf ("Too many clients\n");
+				LOG_WARN("Too many clients");
 				break;
     			}
 			FD_SET (sock, &allset);     // add new descriptor to set
@@ -154,20 +167,37 @@ int SelectServer::run()
 			if ((sockfd = client[i]) < 0){
 				continue;
 			}
+			OutputBuffer* out = ClientData::Instance()->output(sockfd);
+			if (FD_ISSET(sockfd, &wset)) {
+				// room for output a slow reader left behind
+				--nready;
+				if(out->flush(sockfd) < 0){
+					close_client(sockfd);
+					continue;
+				}
+				update_interest(sockfd, out);
+			}
 			if (FD_ISSET(sockfd, &rset)) {
 				char buf[_buflen];
-				if(recv_msgs(sockfd, buf)<0){
+				int n;
+				--nready;
+				if((n = recv_msgs(sockfd, buf))<0){
 					continue;
 				}
-				ClientData::Instance()->setRtt(sockfd);
-
-				send_msgs(sockfd, buf);	
-				ClientData::Instance()->recordData(sockfd, _buflen);
+				if(n > 0){
+					ClientData::Instance()->setRtt(sockfd);
 
-	         		if (--nready <= 0){
-					break;        // no more readable descriptors
+					if(send_msgs(sockfd, buf, n) < 0){
+						close_client(sockfd);
+						continue;
+					}
+					ClientData::Instance()->recordData(sockfd, n);
+					update_interest(sockfd, out);
 				}
 			}
+			if (nready <= 0){
+				break;        // no more ready descriptors
+			}
      		}
 	
 	}
@@ -259,7 +289,7 @@ void SelectServer::listen_for_clients()
 {
 	// Listen for connections
 	
-	listen(serverSock, 20);
+	listen(serverSock, _backlog);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -268,6 +298,7 @@ void SelectServer::listen_for_clients()
 -- DATE: 2014/02/21
 --
 -- REVISIONS: (Date and Description)
+--		2026/10/18 - sets TCP_NODELAY on the connection
 --
 -- DESIGNER: Ian Lee, Luke Tao
 --
@@ -278,6 +309,7 @@ void SelectServer::listen_for_clients()
 -- RETURNS:  New Socket Descriptor
 --
 -- NOTES: Function that blocks until a client connection request comes in. It will add the client to the list.
+-- The connection gets TCP_NODELAY.
 ----------------------------------------------------------------------------------------------------------------------*/
 int SelectServer::accept_client()
 {
@@ -287,11 +319,22 @@ int SelectServer::accept_client()
 	int sServerSock;
 	if ((sServerSock = accept (serverSock, (struct sockaddr *)&client, &client_len)) == -1)
 	{
-		fprintf(stderr, "Can't accept client\n");
+		LOG_WARN("Can't accept client: %s", strerror(errno));
 		return -1;
 	}
 	
+	// non-blocking so a slow reader cannot stall the select loop on send
+	if (fcntl (sServerSock, F_SETFL, O_NONBLOCK | fcntl(sServerSock, F_GETFL, 0)) == -1) {
+		fprintf(stderr,"fcntl\n");
+	}
+	// no Nagle: an echo leaves as soon as it is read
+	int nodelay = 1;
+	if (setsockopt (sServerSock, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1) {
+		perror("setsockopt TCP_NODELAY");
+	}
+	
 	ClientData::Instance()->addClient(sServerSock, inet_ntoa(client.sin_addr),client.sin_port );
+	ClientData::Instance()->recordAccept(1);
 
 	return sServerSock;
 }
@@ -307,17 +350,22 @@ int SelectServer::accept_client()
 --
 -- PROGRAMMER: Ian Lee, Luke Tao
 --
--- INTERFACE: void SelectServer::send_msgs(int socket, char * data)
+-- INTERFACE: int SelectServer::send_msgs(int socket, char * data, int len)
 --					   int socket - server sock
 --					   char * data - data that the server will send back to the client
+--					   int len - number of bytes to send
 --
--- RETURNS:  void
+-- RETURNS:  number of bytes left pending in the client's output buffer, -1 if the socket failed
 --
--- NOTES: Send Messages function used by the select server.
+-- NOTES: Send Messages function used by the select server.  Whatever the socket does not take right away is
+-- kept in the client's output buffer and sent when select reports the socket writable.
 ----------------------------------------------------------------------------------------------------------------------*/
-void SelectServer::send_msgs(int socket, char * data)
+int SelectServer::send_msgs(int socket, char * data, int len)
 {
-	send(socket, data, _buflen, 0);
+	OutputBuffer* out = ClientData::Instance()->output(socket);
+	if (out == NULL)
+		return -1;
+	return out->write(socket, data, len);
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -335,9 +383,9 @@ void SelectServer::send_msgs(int socket, char * data)
 --					  int socket - server socket
 --					  char * bp - data that the server will receive from the client
 --
--- RETURNS:  Socket Descriptor
+-- RETURNS:  number of bytes read, -1 if the client was closed
 --
--- NOTES: Send Messages function used by the select server.
+-- NOTES: Receive Messages function used by the select server.
 ----------------------------------------------------------------------------------------------------------------------*/
 int SelectServer::recv_msgs(int socket, char * bp)
 {
@@ -347,38 +395,27 @@ int SelectServer::recv_msgs(int socket, char * bp)
 	{
 
 		if(n == -1){
-			
-			printf("errno %d on socket %d\n",errno, socket);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
-			FD_CLR(socket, &allset);
-			for (int i =0; i< maxi; ++i){
-				if(client[i]==socket){
-					client[i] = -1;
-					break;
-				}
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
 			}
+			
+			LOG_WARN("recv error %d on socket %d", errno, socket);
+			close_client(socket);
 			return -1;
 		} else if (n == 0){
-			printf("socket was gracefully closed by other side %d\n",socket);
-			ClientData::Instance()->removeClient(socket);
-			close(socket);
-			FD_CLR(socket, &allset);
-			for (int i =0; i< maxi; ++i){
-				if(client[i]==socket){
-					client[i] = -1;
-					break;
-				}
-			}
-			
+			LOG_INFO("socket was gracefully closed by other side %d", socket);
+			close_client(socket);
 			return -1;
 		}
 		//printf("bytes read and to read %d %d /n", n, bytes_to_read);
 		bp += n;
 		bytes_to_read -= n;
 	}
+	if(n > 0){
+		bytes_to_read -= n;
+	}
 	//printf("end recv %d\n",socket);
-	return _buflen;
+	return _buflen - bytes_to_read;
 }
 
 /*-------------------------------------------------------------------------------------------------------------------- 
@@ -419,6 +456,71 @@ int SelectServer::set_sock_option(int listenSocket)
 }
 
 
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: close_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int SelectServer::close_client(int socket)
+--					  int socket - client socket
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Removes and closes the client and takes it out of both select sets and the client array.
+----------------------------------------------------------------------------------------------------------------------*/
+int SelectServer::close_client(int socket)
+{
+	ClientData::Instance()->removeClient(socket);
+	close(socket);
+	FD_CLR(socket, &allset);
+	FD_CLR(socket, &allwset);
+	for (int i =0; i<= maxi; ++i){
+		if(client[i]==socket){
+			client[i] = -1;
+			break;
+		}
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: update_interest
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void SelectServer::update_interest(int socket, OutputBuffer* out)
+--					  int socket - client socket
+--					  OutputBuffer* out - output buffer of the client
+--
+-- RETURNS:  void
+--
+-- NOTES: Watches the socket for writing only while output is pending, and stops reading it while the output
+-- buffer is over its high watermark.
+----------------------------------------------------------------------------------------------------------------------*/
+void SelectServer::update_interest(int socket, OutputBuffer* out)
+{
+	if (out->paused())
+		FD_CLR(socket, &allset);
+	else
+		FD_SET(socket, &allset);
+	if (out->pending() > 0)
+		FD_SET(socket, &allwset);
+	else
+		FD_CLR(socket, &allwset);
+}
+
 /*-------------------------------------------------------------------------------------------------------------------- 
 -- FUNCTION: set_port
 --
@@ -486,4 +588,50 @@ int SelectServer::setBufLen(int buflen){
 	_buflen = buflen;
 	return 1;
 }
-
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_backlog
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int SelectServer::set_backlog(int backlog)
+--					int backlog - length of the listen queue
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets how many pending connections the listen socket queues.  The kernel caps it at somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int SelectServer::set_backlog(int backlog){
+	_backlog = backlog;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: queue_stats
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void SelectServer::queue_stats(stats_snapshot& snap, bool reset)
+--					stats_snapshot& snap - gets the depth, high water mark and push timeouts of fd_queue
+--					bool reset           - start the high water mark over
+--
+-- RETURNS:  void
+--
+-- NOTES: Probe given to ClientData for the stats.  The queue keeps these in atomics, so its lock is not taken.
+----------------------------------------------------------------------------------------------------------------------*/
+void SelectServer::queue_stats(stats_snapshot& snap, bool reset){
+	SelectServer* mServer = SelectServer::Instance();
+	snap.queue_depth = (long) mServer->fd_queue.size();
+	snap.queue_high_water = (long) mServer->fd_queue.high_water(reset);
+	snap.push_timeouts = mServer->fd_queue.push_timeouts();
+}
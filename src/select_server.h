@@ -3,6 +3,7 @@
 
 #include "client_data.h"
 #include "blocking_queue.h"
+#include "output_buffer.h"
 
 #include <atomic>
 #include <iostream>
@@ -20,6 +21,7 @@
 #include <signal.h>
 #include <string.h>
 #include <pthread.h>
+#include <fcntl.h>
 
 #define BUFLEN 255
 #define TCP_PORT 7000
@@ -41,15 +43,19 @@ public:
 	int bind_socket();
 	void listen_for_clients();
 	int accept_client();
-	void send_msgs(int socket, char * data);
+	int send_msgs(int socket, char * data, int len);
 	int recv_msgs(int socket, char * bp);
 	int set_sock_option(int listenSocket);
+	int close_client(int socket);
+	void update_interest(int socket, OutputBuffer* out);
 	int set_port(int port);
 	int set_num_threads(int num);
 	int setBufLen(int buflen);
+	int set_backlog(int backlog);
+	static void queue_stats(stats_snapshot& snap, bool reset);
 private:
 
-	int 	serverSock, _port, _numThreads;
+	int 	serverSock, _port, _backlog, _numThreads;
 
 
 	
@@ -62,6 +68,8 @@ private:
 	int client[MAXCLIENTS];
 	fd_set allset;
 	fd_set rset;
+	fd_set allwset;
+	fd_set wset;
 	int _buflen;
 
 };
@@ -0,0 +1,165 @@
+#include "stats_shm.h"
+#include <getopt.h>
+
+static void printSample(const stats_shm_sample& now, const stats_shm_sample* last);
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: stats_reader.cpp - Hold the code for the tool that reads the server's shared memory stats.
+--
+-- PROGRAM: stats_reader
+--
+-- FUNCTIONS: int main(int argc, char **argv)
+--			  static void printSample(const stats_shm_sample& now, const stats_shm_sample* last)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Attaches read-only to the segment a server opened with -S and prints a line per interval.  Reading never
+-- makes the server do anything, so it can sample as often as the server publishes (every 10ms).
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: main (stats_reader)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int main(int argc, char **argv)
+--		       int argc - number of cmd-line arguments
+--		       char **argv - double pointer to array of arguments
+--
+-- RETURNS:  0 on success, 1 if the segment could not be read
+--
+-- NOTES: With -i 0 the totals since the server started are printed once; otherwise every line covers the
+-- interval since the previous one.  -c stops after that many lines.
+----------------------------------------------------------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	int c;
+	const char* name = STATS_SHM_NAME;
+	long intervalMs = 1000;
+	long count = 0;
+	while ((c = getopt (argc, argv, "S:i:c:")) != -1){
+		switch (c){
+			case 'S':
+				name = optarg;
+				break;
+			case 'i':
+				intervalMs = atol(optarg);
+				break;
+			case 'c':
+				count = atol(optarg);
+				break;
+			case '?':
+			default:
+				fprintf(stderr, "Usage: %s [-S shmName] [-i intervalMs] [-c count]\n", argv[0]);
+				exit(1);
+		}
+	}
+
+	const stats_shm* seg = StatsShm::attach(name);
+	if(seg == NULL){
+		exit(1);
+	}
+	static stats_shm_sample samples[2];
+	stats_shm_sample* last = &samples[0];
+	stats_shm_sample* now = &samples[1];
+	if(StatsShm::read(seg, *last) < 0){
+		fprintf(stderr, "%s: no consistent sample\n", name);
+		exit(1);
+	}
+	if(intervalMs <= 0){
+		printSample(*last, NULL);
+		return 0;
+	}
+
+	const struct timespec timeout {intervalMs / 1000, (intervalMs % 1000) * 1000000};
+	for(long lines = 0; count == 0 || lines < count; lines++){
+		nanosleep(&timeout, NULL);
+		if(StatsShm::read(seg, *now) < 0){
+			fprintf(stderr, "%s: no consistent sample\n", name);
+			continue;
+		}
+		// a new server took over the segment: start over from its counters
+		if(now->pid != last->pid || now->seq < last->seq){
+			printf("server restarted, pid %ld\n", now->pid);
+			printSample(*now, NULL);
+		} else {
+			printSample(*now, last);
+		}
+		fflush(stdout);
+		stats_shm_sample* t = last;
+		last = now;
+		now = t;
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: printSample
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static void printSample(const stats_shm_sample& now, const stats_shm_sample* last)
+--					const stats_shm_sample& now   - latest sample
+--					const stats_shm_sample* last  - previous sample, NULL to print the totals
+--
+-- RETURNS:  void
+--
+-- NOTES: Rates, percentiles and busy time cover the time between the two samples.  A line is marked stale when
+-- the server has not published since the previous one.
+----------------------------------------------------------------------------------------------------------------------*/
+static void printSample(const stats_shm_sample& now, const stats_shm_sample* last)
+{
+	HistogramSnapshot rtt = now.stats.rtt;
+	uint64_t messages = now.stats.messages, bytes = now.stats.bytes, rtt_sum = now.stats.rtt_sum;
+	uint64_t busy = 0, lastBusy = 0;
+	double elapsed = 0;
+
+	for(int i = 0; i < now.threads; i++){
+		busy += now.busy_ns[i];
+	}
+	if(last != NULL){
+		elapsed = (now.stats.when.tv_sec - last->stats.when.tv_sec)
+			+ (now.stats.when.tv_nsec - last->stats.when.tv_nsec) / 1e9;
+		rtt.subtract(last->stats.rtt);
+		messages -= last->stats.messages;
+		bytes -= last->stats.bytes;
+		rtt_sum -= last->stats.rtt_sum;
+		for(int i = 0; i < last->threads; i++){
+			lastBusy += last->busy_ns[i];
+		}
+	}
+
+	printf("clients: %ld \tqueue: %ld", now.stats.clients, now.stats.queue_depth);
+	if(last == NULL){
+		printf(" \tmsgs: %lu \tbytes: %lu", (unsigned long) messages, (unsigned long) bytes);
+	} else if(elapsed > 0){
+		printf(" \tmsgs/s: %.0lf \tbytes/s: %.0lf", messages / elapsed, bytes / elapsed);
+	} else {
+		printf(" \tstale");
+	}
+	printf(" \tRTT(us) avg: %.0lf \tp50: %lu \tp99: %lu \tmax: %lu",
+		rtt.total() > 0 ? (double) rtt_sum / rtt.total() : 0.0, (unsigned long) rtt.percentile(50),
+		(unsigned long) rtt.percentile(99), (unsigned long) rtt.max());
+	if(last != NULL && elapsed > 0 && now.threads > 0 && busy >= lastBusy){
+		printf(" \tbusy: %.1lf%% of %d threads", (busy - lastBusy) / (elapsed * 1e9 * now.threads) * 100, now.threads);
+	}
+	printf("\n");
+}
@@ -0,0 +1,353 @@
+#include "stats_shm.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: stats_shm.cpp - Hold the code for the shared memory stats segment.
+--
+-- PROGRAM: server, stats_reader
+--
+-- FUNCTIONS: StatsShm::StatsShm()
+--			  StatsShm* StatsShm::Instance()
+--			  int StatsShm::open(const char* name)
+--			  bool StatsShm::enabled()
+--			  void StatsShm::publish(const stats_snapshot& now)
+--			  void StatsShm::unlink()
+--			  const stats_shm* StatsShm::attach(const char* name)
+--			  int StatsShm::read(const stats_shm* seg, stats_shm_sample& sample)
+--
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: The server's stats thread is the only writer.  Every field is an atomic with relaxed ordering; the
+-- fences around the writes and the copy make the sequence number check a proper seqlock.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: StatsShm (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: StatsShm::StatsShm()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Nothing is published until a segment is opened.
+----------------------------------------------------------------------------------------------------------------------*/
+StatsShm::StatsShm() : _seg(NULL)
+{
+	_name[0] = '\0';
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: StatsShm* StatsShm::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates the instance of the segment writer.
+----------------------------------------------------------------------------------------------------------------------*/
+StatsShm* StatsShm::Instance()
+{
+	static StatsShm m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: open
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int StatsShm::open(const char* name)
+--					const char* name - shm_open name, starting with a slash
+--
+-- RETURNS:  0 on success, -1 on error
+--
+-- NOTES: Creates the segment, or takes over the one a previous server left behind, and stamps it with the
+-- layout version.  Readers that are still attached see the magic go away while it is reset.  A server that
+-- died while publishing left seq odd, which would keep every reader retrying, so seq is moved on to the next
+-- even number: never back, so a reader that was part way through a copy still sees it change.
+----------------------------------------------------------------------------------------------------------------------*/
+int StatsShm::open(const char* name)
+{
+	int fd;
+	void * mem;
+
+	if((fd = shm_open(name, O_CREAT | O_RDWR | O_CLOEXEC, 0644)) == -1){
+		perror("shm_open");
+		return -1;
+	}
+	if(ftruncate(fd, sizeof(struct stats_shm)) == -1){
+		perror("ftruncate stats segment");
+		::close(fd);
+		return -1;
+	}
+	mem = mmap(NULL, sizeof(struct stats_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		perror("mmap stats segment");
+		return -1;
+	}
+	_seg = (struct stats_shm*) mem;
+	_seg->magic.store(0, std::memory_order_relaxed);
+	_seg->seq.store((_seg->seq.load(std::memory_order_relaxed) + 2) & ~1ULL, std::memory_order_relaxed);
+	_seg->version.store(STATS_SHM_VERSION, std::memory_order_relaxed);
+	_seg->pid.store(getpid(), std::memory_order_relaxed);
+	_seg->interval_ns.store(STATS_SHM_INTERVAL_NS, std::memory_order_relaxed);
+	_seg->magic.store(STATS_SHM_MAGIC, std::memory_order_release);
+	snprintf(_name, sizeof(_name), "%s", name);
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: enabled
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: bool StatsShm::enabled()
+--
+-- RETURNS:  true once a segment is open
+--
+-- NOTES: The stats thread only ticks at the segment's rate when there is one.
+----------------------------------------------------------------------------------------------------------------------*/
+bool StatsShm::enabled(){
+	return _seg != NULL;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: publish
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void StatsShm::publish(const stats_snapshot& now)
+--					const stats_snapshot& now - totals to publish
+--
+-- RETURNS:  void
+--
+-- NOTES: Called by the stats thread only.  Also copies the busy time of the first STATS_SHM_THREADS threads
+-- that have a role.
+----------------------------------------------------------------------------------------------------------------------*/
+void StatsShm::publish(const stats_snapshot& now){
+	struct stats_shm* s = _seg;
+	uint64_t seq = s->seq.load(std::memory_order_relaxed);
+
+	s->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	s->when_ns.store((uint64_t) now.when.tv_sec * 1000000000ULL + now.when.tv_nsec, std::memory_order_relaxed);
+	s->clients.store(now.clients, std::memory_order_relaxed);
+	s->queue_depth.store(now.queue_depth, std::memory_order_relaxed);
+	s->messages.store(now.messages, std::memory_order_relaxed);
+	s->bytes.store(now.bytes, std::memory_order_relaxed);
+	s->accepts.store(now.accepts, std::memory_order_relaxed);
+	s->rtt_sum.store(now.rtt_sum, std::memory_order_relaxed);
+	s->sends_copied.store(now.sends_copied, std::memory_order_relaxed);
+	s->sends_zerocopy.store(now.sends_zerocopy, std::memory_order_relaxed);
+	s->zerocopy_done.store(now.zerocopy_done, std::memory_order_relaxed);
+	s->zerocopy_copied.store(now.zerocopy_copied, std::memory_order_relaxed);
+
+	int n = ThreadStats::count(), used = 0;
+	for(int i = 0; i < n && used < STATS_SHM_THREADS; i++){
+		thread_stats* t = ThreadStats::at(i);
+		const char* role = t->role.load(std::memory_order_relaxed);
+		if(role == NULL || !t->timed.load(std::memory_order_relaxed)){
+			continue;
+		}
+		uint64_t packed[2] = {0, 0};
+		memcpy(packed, role, std::min(strlen(role), sizeof(packed)));
+		s->thread[used].busy_ns.store(t->busy_ns.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		s->thread[used].role[0].store(packed[0], std::memory_order_relaxed);
+		s->thread[used].role[1].store(packed[1], std::memory_order_relaxed);
+		used++;
+	}
+	s->threads.store(used, std::memory_order_relaxed);
+	for(int i = 0; i < HIST_BUCKETS; i++){
+		s->rtt[i].store(now.rtt.count(i), std::memory_order_relaxed);
+	}
+
+	std::atomic_thread_fence(std::memory_order_release);
+	s->seq.store(seq + 2, std::memory_order_relaxed);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: unlink
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void StatsShm::unlink()
+--
+-- RETURNS:  void
+--
+-- NOTES: Removes the segment name on shutdown.  Readers still attached keep the last numbers.
+----------------------------------------------------------------------------------------------------------------------*/
+void StatsShm::unlink(){
+	if(_seg != NULL){
+		shm_unlink(_name);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: attach
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: const stats_shm* StatsShm::attach(const char* name)
+--					const char* name - shm_open name of the server's segment
+--
+-- RETURNS:  the read-only mapping, NULL on error
+--
+-- NOTES: For readers.  Fails if the segment is too small or has another layout version.
+----------------------------------------------------------------------------------------------------------------------*/
+const stats_shm* StatsShm::attach(const char* name)
+{
+	int fd;
+	struct stat st;
+	void * mem;
+
+	if((fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0)) == -1){
+		perror("shm_open");
+		return NULL;
+	}
+	if(fstat(fd, &st) == -1 || st.st_size < (off_t) sizeof(struct stats_shm)){
+		fprintf(stderr, "%s is not a stats segment of this version\n", name);
+		::close(fd);
+		return NULL;
+	}
+	mem = mmap(NULL, sizeof(struct stats_shm), PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		perror("mmap stats segment");
+		return NULL;
+	}
+	const struct stats_shm* seg = (const struct stats_shm*) mem;
+	if(seg->magic.load(std::memory_order_acquire) != STATS_SHM_MAGIC
+		|| seg->version.load(std::memory_order_relaxed) != STATS_SHM_VERSION){
+		fprintf(stderr, "%s has version %u, expected %u\n", name,
+			seg->version.load(std::memory_order_relaxed), STATS_SHM_VERSION);
+		munmap(mem, sizeof(struct stats_shm));
+		return NULL;
+	}
+	return seg;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: read
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int StatsShm::read(const stats_shm* seg, stats_shm_sample& sample)
+--					const stats_shm* seg     - segment from attach()
+--					stats_shm_sample& sample - receives a consistent copy
+--
+-- RETURNS:  0 on success, -1 if every try raced a write or nothing has been published yet
+--
+-- NOTES: Copies the segment and retries when the sequence number shows a write overlapped the copy.  A write
+-- takes a few microseconds every 10ms, so a retry is rare.
+----------------------------------------------------------------------------------------------------------------------*/
+int StatsShm::read(const stats_shm* seg, stats_shm_sample& sample)
+{
+	for(int attempt = 0; attempt < STATS_SHM_RETRIES; attempt++){
+		uint64_t before = seg->seq.load(std::memory_order_acquire);
+		if(before == 0){
+			return -1;
+		}
+		if(before & 1){
+			continue;
+		}
+
+		uint64_t when = seg->when_ns.load(std::memory_order_relaxed);
+		sample.stats.when.tv_sec = when / 1000000000ULL;
+		sample.stats.when.tv_nsec = when % 1000000000ULL;
+		sample.stats.clients = seg->clients.load(std::memory_order_relaxed);
+		sample.stats.queue_depth = seg->queue_depth.load(std::memory_order_relaxed);
+		sample.stats.messages = seg->messages.load(std::memory_order_relaxed);
+		sample.stats.bytes = seg->bytes.load(std::memory_order_relaxed);
+		sample.stats.accepts = seg->accepts.load(std::memory_order_relaxed);
+		sample.stats.rtt_sum = seg->rtt_sum.load(std::memory_order_relaxed);
+		sample.stats.sends_copied = seg->sends_copied.load(std::memory_order_relaxed);
+		sample.stats.sends_zerocopy = seg->sends_zerocopy.load(std::memory_order_relaxed);
+		sample.stats.zerocopy_done = seg->zerocopy_done.load(std::memory_order_relaxed);
+		sample.stats.zerocopy_copied = seg->zerocopy_copied.load(std::memory_order_relaxed);
+		sample.pid = seg->pid.load(std::memory_order_relaxed);
+		sample.interval_ns = seg->interval_ns.load(std::memory_order_relaxed);
+		sample.threads = seg->threads.load(std::memory_order_relaxed);
+		if(sample.threads > STATS_SHM_THREADS){
+			sample.threads = STATS_SHM_THREADS;
+		}
+		for(int i = 0; i < sample.threads; i++){
+			uint64_t packed[2];
+			sample.busy_ns[i] = seg->thread[i].busy_ns.load(std::memory_order_relaxed);
+			packed[0] = seg->thread[i].role[0].load(std::memory_order_relaxed);
+			packed[1] = seg->thread[i].role[1].load(std::memory_order_relaxed);
+			memcpy(sample.role[i], packed, sizeof(packed));
+			sample.role[i][sizeof(packed)] = '\0';
+		}
+		sample.stats.rtt.clear();
+		for(int i = 0; i < HIST_BUCKETS; i++){
+			sample.stats.rtt.add(i, seg->rtt[i].load(std::memory_order_relaxed));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(seg->seq.load(std::memory_order_relaxed) == before){
+			sample.seq = before;
+			return 0;
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,96 @@
+#ifndef STATS_SHM_H
+#define STATS_SHM_H
+
+#include "histogram.h"
+#include "thread_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define STATS_SHM_NAME "/scalable_server"	// default segment, shows up as /dev/shm/scalable_server
+#define STATS_SHM_MAGIC 0x53545353			// "SSTS"
+#define STATS_SHM_VERSION 1					// bump whenever struct stats_shm changes
+#define STATS_SHM_THREADS 64				// per-thread busy times published, the rest are left out
+#define STATS_SHM_INTERVAL_NS 10000000		// the server publishes every 10ms
+#define STATS_SHM_RETRIES 1000				// reads that may race a write before a reader gives up
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "the segment needs lock-free 64 bit atomics to be shared between processes");
+
+/**
+busy time of one thread, with its role packed into two words so the whole
+segment is plain atomics.
+*/
+struct stats_shm_thread {
+	std::atomic<uint64_t> busy_ns;
+	std::atomic<uint64_t> role[2];		// nul padded, 16 characters at most
+};
+
+/**
+layout of the shared memory segment.  a seqlock: the server makes seq odd,
+writes the fields and makes it even again; a reader copies the fields and
+keeps the copy only if seq was the same even number before and after.  the
+server never waits for a reader, and a reader costs the server nothing.
+magic is written last when the segment is created, version is the layout.
+*/
+struct stats_shm {
+	std::atomic<uint32_t> magic;
+	std::atomic<uint32_t> version;
+	std::atomic<uint64_t> seq;
+	std::atomic<uint64_t> pid;
+	std::atomic<uint64_t> interval_ns;
+	std::atomic<uint64_t> when_ns;		// CLOCK_MONOTONIC of the snapshot
+	std::atomic<uint64_t> clients;
+	std::atomic<int64_t> queue_depth;	// -1 if the server has no queue
+	std::atomic<uint64_t> messages, bytes, accepts, rtt_sum;
+	std::atomic<uint64_t> sends_copied, sends_zerocopy, zerocopy_done, zerocopy_copied;
+	std::atomic<uint64_t> threads;		// entries of thread[] in use
+	struct stats_shm_thread thread[STATS_SHM_THREADS];
+	std::atomic<uint64_t> rtt[HIST_BUCKETS];
+};
+
+/**
+one consistent copy of the segment, taken by a reader.
+*/
+struct stats_shm_sample {
+	uint64_t seq;
+	long pid;
+	uint64_t interval_ns;
+	stats_snapshot stats;
+	int threads;
+	uint64_t busy_ns[STATS_SHM_THREADS];
+	char role[STATS_SHM_THREADS][17];
+};
+
+/**
+writer side for the server, plus attach/read for stats_reader.
+*/
+class StatsShm {
+
+public:
+	static StatsShm* Instance();
+
+	int open(const char* name);
+	bool enabled();
+	void publish(const stats_snapshot& now);
+	void unlink();
+
+	static const stats_shm* attach(const char* name);
+	static int read(const stats_shm* seg, stats_shm_sample& sample);
+private:
+	StatsShm();
+
+	struct stats_shm* _seg;
+	char _name[256];
+};
+
+#endif
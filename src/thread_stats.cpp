@@ -0,0 +1,347 @@
+#include "thread_stats.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: thread_stats.cpp - Hold the code for the registry of per-thread statistics blocks.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: int ThreadStats::count()
+--			  thread_stats* ThreadStats::at(int i)
+--			  void ThreadStats::merge(stats_snapshot& snap)
+--			  void ThreadStats::set_role(const char* role, bool timed)
+--			  void ThreadStats::sample_usage(thread_stats* t, uint64_t now)
+--			  thread_stats* ThreadStats::claim()
+--			  void ThreadStats::release(void * block)
+--			  void ThreadStats::make_key()
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Blocks are allocated the first time a thread records something and are never freed, so the stats
+-- thread can read any block it sees without synchronising with the thread that owns it.
+----------------------------------------------------------------------------------------------------------------------*/
+
+__thread thread_stats* ThreadStats::_local = NULL;
+__thread bool stat_shared = false;
+__thread uintptr_t ThreadStats::_stack_lo = 0;
+__thread uintptr_t ThreadStats::_stack_hi = 0;
+thread_stats* ThreadStats::_blocks[MAX_STAT_THREADS];
+std::atomic<int> ThreadStats::_count(0);
+std::atomic<thread_stats*> ThreadStats::_overflow(NULL);
+pthread_mutex_t ThreadStats::_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_key_t ThreadStats::_key;
+pthread_once_t ThreadStats::_once = PTHREAD_ONCE_INIT;
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: count
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int ThreadStats::count()
+--
+-- RETURNS:  number of blocks that can be read with at()
+--
+-- NOTES: Blocks of threads that have exited are included; their counts are part of the totals.
+----------------------------------------------------------------------------------------------------------------------*/
+int ThreadStats::count(){
+	return _count.load(std::memory_order_acquire);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: at
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: thread_stats* ThreadStats::at(int i)
+--				int i - block index, below count()
+--
+-- RETURNS:  the block
+--
+-- NOTES: For the stats thread; the block's fields may only be read.
+----------------------------------------------------------------------------------------------------------------------*/
+thread_stats* ThreadStats::at(int i){
+	return _blocks[i];
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: merge
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ThreadStats::merge(stats_snapshot& snap)
+--				stats_snapshot& snap - filled with the sums of every block
+--
+-- RETURNS:  void
+--
+-- NOTES: Only reads the blocks, so the threads keep recording while it runs.  The overflow block is summed
+-- too.  The time, client count and queue figures of the snapshot are left to the caller.
+----------------------------------------------------------------------------------------------------------------------*/
+void ThreadStats::merge(stats_snapshot& snap){
+	snap.messages = snap.bytes = snap.accepts = snap.rtt_sum = 0;
+	snap.sends_copied = snap.sends_zerocopy = snap.zerocopy_done = snap.zerocopy_copied = 0;
+	snap.connects = snap.connect_retries = snap.connect_failures = 0;
+	snap.rtt.clear();
+	snap.push_wait.clear();
+	snap.pop_wait.clear();
+	snap.latency.clear();
+	snap.request.clear();
+	snap.connect.clear();
+	int n = count();
+	for(int i = 0; i <= n; i++){
+		thread_stats* t = i < n ? _blocks[i] : _overflow.load(std::memory_order_acquire);
+		if(t == NULL){
+			break;
+		}
+		snap.messages += t->messages.load(std::memory_order_relaxed);
+		snap.bytes += t->bytes.load(std::memory_order_relaxed);
+		snap.accepts += t->accepts.load(std::memory_order_relaxed);
+		snap.rtt_sum += t->rtt_sum.load(std::memory_order_relaxed);
+		snap.sends_copied += t->sends_copied.load(std::memory_order_relaxed);
+		snap.sends_zerocopy += t->sends_zerocopy.load(std::memory_order_relaxed);
+		snap.zerocopy_done += t->zerocopy_done.load(std::memory_order_relaxed);
+		snap.zerocopy_copied += t->zerocopy_copied.load(std::memory_order_relaxed);
+		snap.connects += t->connects.load(std::memory_order_relaxed);
+		snap.connect_retries += t->connect_retries.load(std::memory_order_relaxed);
+		snap.connect_failures += t->connect_failures.load(std::memory_order_relaxed);
+		t->rtt.add_to(snap.rtt);
+		t->push_wait.add_to(snap.push_wait);
+		t->pop_wait.add_to(snap.pop_wait);
+		t->latency.add_to(snap.latency);
+		t->request.add_to(snap.request);
+		t->connect.add_to(snap.connect);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_role
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ThreadStats::set_role(const char* role, bool timed)
+--				const char* role - string literal naming what the calling thread does
+--				bool timed       - the thread keeps busy_ns
+--
+-- RETURNS:  void
+--
+-- NOTES: Labels the calling thread's block, so its CPU time can be reported per role and, for a timed thread,
+-- its busy time per worker.  The string is not copied and must outlive the server.  Also notes where the
+-- thread's stack is, for the profiler's stack walks.  A thread on the overflow block stays unlabelled.
+----------------------------------------------------------------------------------------------------------------------*/
+void ThreadStats::set_role(const char* role, bool timed){
+	thread_stats* t = local();
+	pthread_attr_t attr;
+	void* addr;
+	size_t size;
+	if(_stack_hi == 0 && pthread_getattr_np(pthread_self(), &attr) == 0){
+		if(pthread_attr_getstack(&attr, &addr, &size) == 0){
+			_stack_lo = (uintptr_t) addr;
+			_stack_hi = (uintptr_t) addr + size;
+		}
+		pthread_attr_destroy(&attr);
+	}
+	if(t->shared){
+		return;
+	}
+	t->role.store(role, std::memory_order_relaxed);
+	t->timed.store(timed, std::memory_order_relaxed);
+	sample_usage(t, stat_now_ns());
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sample_usage
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ThreadStats::sample_usage(thread_stats* t, uint64_t now)
+--				thread_stats* t - the calling thread's block
+--				uint64_t now    - stat_now_ns() of the caller
+--
+-- RETURNS:  void
+--
+-- NOTES: Adds what CLOCK_THREAD_CPUTIME_ID and getrusage(RUSAGE_THREAD) went up by since the last sample to
+-- the block's counters.  Both only cover the calling thread, so only the owner can sample its block.  A thread
+-- that blocks keeps its last sample until it runs again, which is fine: it uses no CPU meanwhile.
+----------------------------------------------------------------------------------------------------------------------*/
+void ThreadStats::sample_usage(thread_stats* t, uint64_t now){
+	struct timespec ts;
+	struct rusage ru;
+	if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0){
+		uint64_t cpu = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+		if(cpu > t->seen_cpu_ns){
+			stat_add(t->cpu_ns, cpu - t->seen_cpu_ns);
+			t->seen_cpu_ns = cpu;
+		}
+	}
+	if(getrusage(RUSAGE_THREAD, &ru) == 0){
+		if((uint64_t) ru.ru_nvcsw > t->seen_voluntary){
+			stat_add(t->csw_voluntary, ru.ru_nvcsw - t->seen_voluntary);
+			t->seen_voluntary = ru.ru_nvcsw;
+		}
+		if((uint64_t) ru.ru_nivcsw > t->seen_involuntary){
+			stat_add(t->csw_involuntary, ru.ru_nivcsw - t->seen_involuntary);
+			t->seen_involuntary = ru.ru_nivcsw;
+		}
+	}
+	t->usage_ns = now;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: claim
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: thread_stats* ThreadStats::claim()
+--
+-- RETURNS:  the calling thread's block
+--
+-- NOTES: Called once per thread.  Reuses the block of a thread that has exited if there is one, otherwise
+-- allocates a new one; with MAX_STAT_THREADS blocks taken, the thread gets the overflow block instead, so the
+-- clocks and role of a block another thread owns are never reset.  The lock is only taken here, never while
+-- recording.
+----------------------------------------------------------------------------------------------------------------------*/
+thread_stats* ThreadStats::claim(){
+	pthread_once(&_once, make_key);
+	thread_stats* block = NULL;
+
+	pthread_mutex_lock(&_lock);
+	int n = _count.load(std::memory_order_relaxed);
+	for(int i = 0; i < n && block == NULL; i++){
+		if(!_blocks[i]->in_use.load(std::memory_order_relaxed)){
+			block = _blocks[i];
+		}
+	}
+	if(block == NULL && n < MAX_STAT_THREADS){
+		void * mem;
+		if(posix_memalign(&mem, CACHE_LINE, sizeof(thread_stats)) == 0){
+			block = new (mem) thread_stats();
+			_blocks[n] = block;
+			_count.store(n + 1, std::memory_order_release);
+		}
+	}
+	if(block == NULL){
+		// out of blocks: share the overflow block, which nobody resets, times or samples
+		block = _overflow.load(std::memory_order_relaxed);
+		void * mem;
+		if(block == NULL && posix_memalign(&mem, CACHE_LINE, sizeof(thread_stats)) == 0){
+			block = new (mem) thread_stats();
+			block->in_use.store(true, std::memory_order_relaxed);
+			block->shared = true;
+			block->rtt.set_shared();
+			block->push_wait.set_shared();
+			block->pop_wait.set_shared();
+			block->latency.set_shared();
+			block->request.set_shared();
+			block->connect.set_shared();
+			_overflow.store(block, std::memory_order_release);
+		}
+		pthread_mutex_unlock(&_lock);
+		if(block == NULL){
+			fprintf(stderr, "out of memory for thread stats\n");
+			exit(1);
+		}
+		// no key: there is nothing to release when the thread exits
+		stat_shared = true;
+		_local = block;
+		return block;
+	}
+	block->in_use.store(true, std::memory_order_relaxed);
+	block->role.store(NULL, std::memory_order_relaxed);
+	block->timed.store(false, std::memory_order_relaxed);
+	// the new thread's clocks start from zero
+	block->usage_ns = block->seen_cpu_ns = block->seen_voluntary = block->seen_involuntary = 0;
+	pthread_mutex_unlock(&_lock);
+
+	_local = block;
+	pthread_setspecific(_key, block);
+	return block;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: release
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ThreadStats::release(void * block)
+--				void * block - block of the exiting thread
+--
+-- RETURNS:  void
+--
+-- NOTES: Thread exit destructor.  Takes a last usage sample, which it can since it runs on the exiting thread,
+-- and lets the next new thread take over the block, counts included.
+----------------------------------------------------------------------------------------------------------------------*/
+void ThreadStats::release(void * block){
+	sample_usage((thread_stats*) block, stat_now_ns());
+	pthread_mutex_lock(&_lock);
+	((thread_stats*) block)->in_use.store(false, std::memory_order_relaxed);
+	pthread_mutex_unlock(&_lock);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: make_key
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void ThreadStats::make_key()
+--
+-- RETURNS:  void
+--
+-- NOTES: Creates the thread key whose destructor releases a block when its thread exits.
+----------------------------------------------------------------------------------------------------------------------*/
+void ThreadStats::make_key(){
+	if(pthread_key_create(&_key, release) != 0){
+		fprintf(stderr, "pthread_key_create\n");
+	}
+}
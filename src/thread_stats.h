@@ -0,0 +1,175 @@
+#ifndef THREAD_STATS_H
+#define THREAD_STATS_H
+
+#include "histogram.h"
+#include "clock_source.h"
+
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <new>
+#include <sys/resource.h>
+#include <time.h>
+
+#ifndef CACHE_LINE
+#define CACHE_LINE 64
+#endif
+
+#define MAX_STAT_THREADS 1024
+#define USAGE_SAMPLE_NS 10000000	// a thread reads its own CPU time and context switches at most every 10ms
+
+/**
+statistics kept by one thread.  only the owning thread writes to a block, so
+recording needs no lock; the stats thread reads every block to merge them.
+blocks are cache-line aligned so two threads never write the same line.
+*/
+struct alignas(CACHE_LINE) thread_stats {
+	std::atomic<bool> in_use;
+	bool shared;							// the overflow block: no role, never timed or sampled
+	std::atomic<uint64_t> messages;			// messages received
+	std::atomic<uint64_t> bytes;			// bytes echoed
+	std::atomic<uint64_t> accepts;			// connections accepted
+	std::atomic<uint64_t> rtt_sum;			// sum of the rtts in the histogram, in microseconds
+	std::atomic<uint64_t> sends_copied;		// echoes below the zero-copy threshold
+	std::atomic<uint64_t> sends_zerocopy;	// echoes sent with MSG_ZEROCOPY
+	std::atomic<uint64_t> zerocopy_done;	// MSG_ZEROCOPY sends completed
+	std::atomic<uint64_t> zerocopy_copied;	// ... of which the kernel copied after all
+	std::atomic<uint64_t> busy_ns;			// time spent handling work rather than waiting for it
+	std::atomic<const char*> role;			// what the thread does, NULL if it never said
+	std::atomic<bool> timed;				// busy_ns is kept: a worker, reactor or ring
+	std::atomic<uint64_t> cpu_ns;			// CPU time, as of the thread's last usage sample
+	std::atomic<uint64_t> csw_voluntary;	// context switches because the thread blocked...
+	std::atomic<uint64_t> csw_involuntary;	// ...and because it was preempted
+	std::atomic<uint64_t> connects;			// client: connections opened
+	std::atomic<uint64_t> connect_retries;	// client: connects that failed and were tried again
+	std::atomic<uint64_t> connect_failures;	// client: connections given up on
+	std::atomic<uint64_t> conns_lost;		// client: connections that closed or failed before their last echo
+	std::atomic<uint64_t> echo_mismatches;	// client: echoes whose stamp was not the next message's
+	// owner only: when the usage was last sampled and what the thread's clocks read then
+	uint64_t usage_ns, seen_cpu_ns, seen_voluntary, seen_involuntary;
+	Histogram rtt;			// time between two messages on a connection, in microseconds
+	Histogram push_wait;	// time the worker queue kept a push waiting for room, in nanoseconds
+	Histogram pop_wait;		// time a worker waited on the queue for work, in nanoseconds
+	Histogram latency;		// client: time from when a message was due to be sent to its echo, in microseconds
+	Histogram request;		// client: time from when a message was sent to its echo, in microseconds
+	Histogram connect;		// client: time from connect() to the connection being open, in microseconds
+};
+
+// set for a thread on the overflow block, which other threads write too
+extern __thread bool stat_shared;
+
+/**
+adds to a counter of the calling thread's own block.  a relaxed load and
+store rather than fetch_add: nothing else writes the counter, so there is no
+locked instruction and the line stays in the owner's cache.  a thread on the
+overflow block shares it, and pays for the fetch_add so no count is lost.
+*/
+static inline void stat_add(std::atomic<uint64_t>& counter, uint64_t n){
+	if(stat_shared){
+		counter.fetch_add(n, std::memory_order_relaxed);
+	} else {
+		counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+}
+
+/**
+monotonic nanoseconds from the hot-path clock, for busy time, waits and traces.
+*/
+static inline uint64_t stat_now_ns(){
+	return ClockSource::now_ns();
+}
+
+/**
+kernel TCP_INFO of the connections sampled in one stats interval, a rotating
+subset of them all.  sums are over the sampled connections; retrans is their
+lifetime retransmits.  times in microseconds, cwnd in segments.
+*/
+struct tcp_sample {
+	long sampled;
+	long recovering;		// sampled connections with a retransmit pending or out of the Open state
+	uint64_t rtt_sum, rtt_max, rttvar_sum, cwnd_sum;
+	uint64_t unacked_sum, unacked_max;		// bytes in the send queue, sent and not acked or not sent yet
+	uint64_t retrans;
+	HistogramSnapshot rtt;
+};
+
+/**
+every thread's statistics added up, taken by the stats thread.  counters are
+totals since the server started; two snapshots give the rates in between.
+*/
+struct stats_snapshot {
+	struct timespec when;	// CLOCK_MONOTONIC
+	long clients;
+	long queue_depth;		// connections waiting for a worker, -1 if the server has no queue
+	long queue_high_water;	// deepest the queue got since the previous stats line
+	uint64_t push_timeouts;	// pushes the queue dropped after their timeout
+	uint64_t messages, bytes, accepts, rtt_sum;
+	uint64_t sends_copied, sends_zerocopy, zerocopy_done, zerocopy_copied;
+	uint64_t connects, connect_retries, connect_failures;
+	HistogramSnapshot rtt;
+	HistogramSnapshot push_wait, pop_wait;
+	HistogramSnapshot latency, request, connect;
+	struct tcp_sample tcp;	// only filled in by snapshots that end an interval
+};
+
+/**
+registry of the per-thread blocks.  a thread claims a block the first time it
+records and gives it back when it exits; the counts stay in the block, so
+totals never go backwards.  once every block is taken further threads share
+an overflow block that only merge() reads: they update it with atomic adds,
+so their counts reach the totals in full, but it has no role, CPU or busy
+time.  with many threads on it the adds contend for its cache lines.
+*/
+class ThreadStats {
+
+public:
+	static thread_stats* local(){
+		return _local != NULL ? _local : claim();
+	}
+	static int count();
+	static thread_stats* at(int i);
+	static void merge(stats_snapshot& snap);
+	static void set_role(const char* role, bool timed = false);
+	/**
+	samples the calling thread's CPU time and context switches if the last
+	sample is USAGE_SAMPLE_NS old.  called from the threads' loops with a
+	time they already took, so it is one compare when nothing is due.
+	*/
+	static void tick(uint64_t now){
+		thread_stats* t = local();
+		if(!t->shared && now - t->usage_ns >= USAGE_SAMPLE_NS){
+			sample_usage(t, now);
+		}
+	}
+	static void sample_usage(thread_stats* t, uint64_t now);
+	/**
+	the calling thread's block if it has one, without claiming one: safe in a
+	signal handler.
+	*/
+	static thread_stats* current() { return _local; }
+	/**
+	bounds of the calling thread's stack, 0 and 0 until it calls set_role.
+	kept per thread rather than in the block, which threads may share.
+	*/
+	static void stack(uintptr_t& lo, uintptr_t& hi){
+		lo = _stack_lo;
+		hi = _stack_hi;
+	}
+private:
+	static thread_stats* claim();
+	static void release(void * block);
+	static void make_key();
+
+	static __thread thread_stats* _local;
+	static __thread uintptr_t _stack_lo, _stack_hi;
+	static thread_stats* _blocks[MAX_STAT_THREADS];	// published before _count is raised past them
+	static std::atomic<thread_stats*> _overflow;		// shared by the threads that found no block, NULL until then
+	static std::atomic<int> _count;
+	static pthread_mutex_t _lock;
+	static pthread_key_t _key;
+	static pthread_once_t _once;
+};
+
+#endif
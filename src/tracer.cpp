@@ -0,0 +1,360 @@
+#include "tracer.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: tracer.cpp - Hold the code for the sampled per-stage request traces.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: static void append_event(std::string& json, const char* name, char ph, int tid, uint64_t id,
+--				uint64_t ts, uint64_t dur)
+--			  Tracer::Tracer()
+--			  Tracer* Tracer::Instance()
+--			  int Tracer::set_rate(int rate)
+--			  uint64_t Tracer::begin(uint64_t token, uint64_t ready)
+--			  void Tracer::end(uint64_t token, uint64_t dequeue, uint64_t recv, uint64_t send)
+--			  struct trace_ring* Tracer::ring()
+--			  void Tracer::dump(std::string& json)
+--			  int Tracer::dump_file(const char* path)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Dumps are in the Chrome trace event format (chrome://tracing, Perfetto).  Every sampled request is an
+-- async event with its stages nested in it, and its time in the worker is a complete event on the worker's row.
+----------------------------------------------------------------------------------------------------------------------*/
+
+__thread struct trace_ring* Tracer::_local = NULL;
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: append_event
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: static void append_event(std::string& json, const char* name, char ph, int tid, uint64_t id,
+--				uint64_t ts, uint64_t dur)
+--					std::string& json - trace the event is added to
+--					const char* name  - event name
+--					char ph           - phase: 'X' complete, 'b'/'e' async begin/end
+--					int tid           - worker row
+--					uint64_t id       - request id of an async event
+--					uint64_t ts       - start in nanoseconds
+--					uint64_t dur      - length in nanoseconds, complete events only
+--
+-- RETURNS:  void
+--
+-- NOTES: Times are written in microseconds with nanosecond decimals, as the format expects.
+----------------------------------------------------------------------------------------------------------------------*/
+static void append_event(std::string& json, const char* name, char ph, int tid, uint64_t id, uint64_t ts, uint64_t dur)
+{
+	char line[256];
+	int n;
+	if(ph == 'X'){
+		n = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lu.%03lu,\"dur\":%lu.%03lu}",
+			name, tid, (unsigned long)(ts / 1000), (unsigned long)(ts % 1000), (unsigned long)(dur / 1000), (unsigned long)(dur % 1000));
+	} else {
+		n = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"request\",\"ph\":\"%c\",\"id\":%lu,\"pid\":1,\"tid\":%d,\"ts\":%lu.%03lu}",
+			name, ph, (unsigned long) id, tid, (unsigned long)(ts / 1000), (unsigned long)(ts % 1000));
+	}
+	if(n > 0 && n < (int) sizeof(line)){
+		json.append(line, n);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Tracer (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Tracer::Tracer()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sampling is off until a rate is set.
+----------------------------------------------------------------------------------------------------------------------*/
+Tracer::Tracer() : _rate(0), _counter(0), _pending(NULL), _count(0), _dumpRequested(false)
+{
+	pthread_mutex_init(&_lock, NULL);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Tracer* Tracer::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates the instance of the tracer.
+----------------------------------------------------------------------------------------------------------------------*/
+Tracer* Tracer::Instance()
+{
+	static Tracer m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_rate
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Tracer::set_rate(int rate)
+--					int rate - trace one request in this many, 0 for none
+--
+-- RETURNS:  0 on success, -1 if the pending slots could not be allocated
+--
+-- NOTES: Must be called before the server starts.
+----------------------------------------------------------------------------------------------------------------------*/
+int Tracer::set_rate(int rate){
+	if(rate > 0 && _pending == NULL){
+		_pending = new (std::nothrow) trace_pending[TRACE_PENDING]();
+		if(_pending == NULL){
+			fprintf(stderr, "out of memory for traces\n");
+			return -1;
+		}
+	}
+	_rate = rate > 0 ? rate : 0;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: begin
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: uint64_t Tracer::begin(uint64_t token, uint64_t ready)
+--					uint64_t token - queue token of the request
+--					uint64_t ready - when epoll_wait returned the event
+--
+-- RETURNS:  the token to queue instead, marked as traced
+--
+-- NOTES: Called by the dispatcher right before the push, so the enqueue stamp is taken here.  The push
+-- publishes the slot to the worker that pops the token.
+----------------------------------------------------------------------------------------------------------------------*/
+uint64_t Tracer::begin(uint64_t token, uint64_t ready){
+	struct trace_pending* p = &_pending[TOKEN_TRACE_SLOT(token)];
+	p->token.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	p->ready.store(ready, std::memory_order_relaxed);
+	p->enqueue.store(stat_now_ns(), std::memory_order_relaxed);
+	p->token.store(token, std::memory_order_release);
+	return token | TOKEN_TRACED_BIT;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: end
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Tracer::end(uint64_t token, uint64_t dequeue, uint64_t recv, uint64_t send)
+--					uint64_t token   - queue token of the request, without the traced mark
+--					uint64_t dequeue - when the worker popped it
+--					uint64_t recv    - when the message was read, 0 if nothing was
+--					uint64_t send    - when the echo was written
+--
+-- RETURNS:  void
+--
+-- NOTES: Called by the worker.  Picks up the dispatcher's stamps if the slot still holds this request, and
+-- writes the record to the worker's own ring.
+----------------------------------------------------------------------------------------------------------------------*/
+void Tracer::end(uint64_t token, uint64_t dequeue, uint64_t recv, uint64_t send){
+	struct trace_ring* r = ring();
+	if(r == NULL){
+		return;
+	}
+	struct trace_pending* p = &_pending[TOKEN_TRACE_SLOT(token)];
+	uint64_t ready = 0, enqueue = 0;
+	if(p->token.load(std::memory_order_acquire) == token){
+		ready = p->ready.load(std::memory_order_relaxed);
+		enqueue = p->enqueue.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(p->token.load(std::memory_order_relaxed) != token){
+			ready = enqueue = 0;
+		}
+	}
+
+	uint64_t head = r->head.load(std::memory_order_relaxed);
+	struct trace_record* t = &r->records[head % TRACE_RING];
+	t->token.store(token, std::memory_order_relaxed);
+	t->ready.store(ready, std::memory_order_relaxed);
+	t->enqueue.store(enqueue, std::memory_order_relaxed);
+	t->dequeue.store(dequeue, std::memory_order_relaxed);
+	t->recv.store(recv != 0 ? recv : send, std::memory_order_relaxed);
+	t->send.store(send, std::memory_order_relaxed);
+	r->head.store(head + 1, std::memory_order_release);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: struct trace_ring* Tracer::ring()
+--
+-- RETURNS:  the calling thread's ring, NULL if there is no room for another
+--
+-- NOTES: A thread's ring is made the first time it records and is never freed, so a dump can always read it.
+----------------------------------------------------------------------------------------------------------------------*/
+struct trace_ring* Tracer::ring(){
+	if(_local != NULL){
+		return _local;
+	}
+	pthread_mutex_lock(&_lock);
+	int n = _count.load(std::memory_order_relaxed);
+	if(n < TRACE_MAX_THREADS){
+		struct trace_ring* r = new (std::nothrow) trace_ring();
+		if(r != NULL){
+			r->role = ThreadStats::local()->role.load(std::memory_order_relaxed);
+			_rings[n] = r;
+			_count.store(n + 1, std::memory_order_release);
+			_local = r;
+		}
+	}
+	pthread_mutex_unlock(&_lock);
+	return _local;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: dump
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Tracer::dump(std::string& json)
+--					std::string& json - receives the trace
+--
+-- RETURNS:  void
+--
+-- NOTES: Reads the rings while the workers keep recording.  Records a worker may be overwriting right now are
+-- left out of a full ring.
+----------------------------------------------------------------------------------------------------------------------*/
+void Tracer::dump(std::string& json){
+	char line[256];
+	json = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"server\"}}";
+
+	int n = _count.load(std::memory_order_acquire);
+	for(int i = 0; i < n; i++){
+		struct trace_ring* r = _rings[i];
+		snprintf(line, sizeof(line), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}",
+			i, r->role != NULL ? r->role : "thread", i);
+		json += line;
+
+		uint64_t head = r->head.load(std::memory_order_acquire);
+		uint64_t first = head > TRACE_RING - TRACE_SLACK ? head - (TRACE_RING - TRACE_SLACK) : 0;
+		for(uint64_t k = first; k < head; k++){
+			struct trace_record* t = &r->records[k % TRACE_RING];
+			uint64_t token = t->token.load(std::memory_order_relaxed);
+			uint64_t ready = t->ready.load(std::memory_order_relaxed);
+			uint64_t enqueue = t->enqueue.load(std::memory_order_relaxed);
+			uint64_t dequeue = t->dequeue.load(std::memory_order_relaxed);
+			uint64_t recv = t->recv.load(std::memory_order_relaxed);
+			uint64_t send = t->send.load(std::memory_order_relaxed);
+			uint64_t id = ((uint64_t) i << 40) | k;
+			uint64_t start = ready != 0 ? ready : dequeue;
+
+			snprintf(line, sizeof(line), "fd %d", (int)(token & 0xffffffff));
+			append_event(json, line, 'b', i, id, start, 0);
+			if(ready != 0){
+				append_event(json, "dispatch", 'b', i, id, ready, 0);
+				append_event(json, "dispatch", 'e', i, id, enqueue, 0);
+				append_event(json, "queue", 'b', i, id, enqueue, 0);
+				append_event(json, "queue", 'e', i, id, dequeue, 0);
+			}
+			append_event(json, "recv", 'b', i, id, dequeue, 0);
+			append_event(json, "recv", 'e', i, id, recv, 0);
+			append_event(json, "send", 'b', i, id, recv, 0);
+			append_event(json, "send", 'e', i, id, send, 0);
+			append_event(json, line, 'e', i, id, send, 0);
+			append_event(json, "echo", 'X', i, 0, dequeue, send - dequeue);
+		}
+	}
+	json += "\n]}\n";
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: dump_file
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Tracer::dump_file(const char* path)
+--					const char* path - file to write, replaced if it exists
+--
+-- RETURNS:  0 on success, -1 on error
+--
+-- NOTES: Run by the stats thread after SIGUSR1, never by the signal handler itself.
+----------------------------------------------------------------------------------------------------------------------*/
+int Tracer::dump_file(const char* path){
+	std::string json;
+	dump(json);
+	FILE* f = fopen(path, "w");
+	if(f == NULL){
+		perror("trace file");
+		return -1;
+	}
+	size_t written = fwrite(json.data(), 1, json.size(), f);
+	if(fclose(f) != 0 || written != json.size()){
+		perror("trace file");
+		return -1;
+	}
+	fprintf(stderr, "trace written to %s\n", path);
+	return 0;
+}
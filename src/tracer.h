@@ -0,0 +1,98 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "thread_stats.h"
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define TRACE_RING 4096			// requests kept per worker, older ones are overwritten
+#define TRACE_SLACK 64			// oldest records of a full ring a dump skips, the owner may be overwriting them
+#define TRACE_PENDING 4096		// sampled requests in flight between the dispatcher and the workers
+#define TRACE_MAX_THREADS 256
+#define TRACE_FILE "test/trace.json"
+
+// a sampled request is queued with the top bit of the token's fd half set; the pending slot is picked by fd
+#define TOKEN_TRACED_BIT (1ULL << 31)
+#define TOKEN_TRACE_SLOT(token) ((token) & (TRACE_PENDING - 1))
+
+/**
+stage timestamps of one sampled request, in CLOCK_MONOTONIC nanoseconds.
+ready and enqueue are 0 when the dispatcher's half was lost.
+*/
+struct trace_record {
+	std::atomic<uint64_t> token;		// fd and generation of the connection
+	std::atomic<uint64_t> ready;		// epoll_wait returned with the event
+	std::atomic<uint64_t> enqueue;		// pushed on fd_queue
+	std::atomic<uint64_t> dequeue;		// popped by the worker
+	std::atomic<uint64_t> recv;			// message read (same as send when spliced)
+	std::atomic<uint64_t> send;			// echo written
+};
+
+/**
+one worker's records.  only the owner writes; a dump reads the newest
+records up to head, which is raised after a record is complete.
+*/
+struct trace_ring {
+	std::atomic<uint64_t> head;
+	const char* role;
+	struct trace_record records[TRACE_RING];
+};
+
+/**
+hand-off slot from the dispatcher to the worker that pops the request.
+token is cleared while the stamps are written, so a worker can tell when a
+slot was reused under it.
+*/
+struct trace_pending {
+	std::atomic<uint64_t> token;
+	std::atomic<uint64_t> ready;
+	std::atomic<uint64_t> enqueue;
+};
+
+/**
+samples one in every rate requests through the epoll server's stages.  the
+dispatcher marks a sampled request in its queue token and leaves its two
+stamps in a pending slot; the worker adds its own and writes the record to
+its ring.  nothing is recorded, and nothing is allocated, when sampling is off.
+*/
+class Tracer {
+
+public:
+	static Tracer* Instance();
+
+	int set_rate(int rate);
+	bool enabled() { return _rate > 0; }
+	bool sample(){
+		if(++_counter < _rate){
+			return false;
+		}
+		_counter = 0;
+		return true;
+	}
+	uint64_t begin(uint64_t token, uint64_t ready);
+	void end(uint64_t token, uint64_t dequeue, uint64_t recv, uint64_t send);
+	void dump(std::string& json);
+	int dump_file(const char* path);
+	void request_dump() { _dumpRequested.store(true, std::memory_order_relaxed); }
+	bool dump_requested() { return _dumpRequested.exchange(false, std::memory_order_relaxed); }
+private:
+	Tracer();
+	struct trace_ring* ring();
+
+	int _rate;
+	int _counter;		// dispatcher only
+	struct trace_pending* _pending;
+	struct trace_ring* _rings[TRACE_MAX_THREADS];
+	std::atomic<int> _count;
+	pthread_mutex_t _lock;		// only taken by a thread making its ring
+	std::atomic<bool> _dumpRequested;
+	static __thread struct trace_ring* _local;
+};
+
+#endif
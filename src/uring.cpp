@@ -0,0 +1,337 @@
+#include "uring.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: uring.cpp - Hold the code for the io_uring ring wrapper used by the io_uring server.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: Uring::Uring()
+--			  Uring::~Uring()
+--			  int Uring::init(unsigned entries)
+--			  struct io_uring_sqe* Uring::get_sqe()
+--			  unsigned Uring::sq_space()
+--			  int Uring::submit(unsigned wait_nr)
+--			  struct io_uring_cqe* Uring::peek_cqe()
+--			  void Uring::cqe_seen()
+--			  int Uring::register_buf_ring(struct io_uring_buf_ring* br, unsigned entries, int bgid)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Talks to the kernel through io_uring_setup/io_uring_enter/io_uring_register directly.  The shared ring
+-- indices are read with acquire and written with release ordering as the io_uring ABI requires.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Uring (constructor)
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Uring::Uring()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Creates an unset ring; call init() before use.
+----------------------------------------------------------------------------------------------------------------------*/
+Uring::Uring() : _fd(-1), _features(0), _sqes(NULL), _sqe_head(0), _sqe_tail(0), _sq_entries(0),
+	_cqes(NULL), _sq_ring(MAP_FAILED), _cq_ring(MAP_FAILED), _sq_ring_size(0), _cq_ring_size(0), _sqes_size(0) {}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: ~Uring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: Uring::~Uring()
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Unmaps the rings and closes the ring fd.
+----------------------------------------------------------------------------------------------------------------------*/
+Uring::~Uring(){
+	if(_sqes != NULL){
+		munmap(_sqes, _sqes_size);
+	}
+	if(_cq_ring != MAP_FAILED && _cq_ring != _sq_ring){
+		munmap(_cq_ring, _cq_ring_size);
+	}
+	if(_sq_ring != MAP_FAILED){
+		munmap(_sq_ring, _sq_ring_size);
+	}
+	if(_fd >= 0){
+		close(_fd);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: init
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Uring::init(unsigned entries)
+--				unsigned entries - submission queue size
+--
+-- RETURNS:  0 on success, -1 on failure with errno set
+--
+-- NOTES: Sets up the ring and maps the submission queue, completion queue and sqe array.  The ring is only
+-- ever driven by one thread, which lets the kernel skip cross-thread task work when it supports it.
+----------------------------------------------------------------------------------------------------------------------*/
+int Uring::init(unsigned entries){
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	p.flags = IORING_SETUP_SUBMIT_ALL | IORING_SETUP_COOP_TASKRUN | IORING_SETUP_SINGLE_ISSUER;
+	p.flags |= IORING_SETUP_CQSIZE;
+	p.cq_entries = entries * 4;
+
+	_fd = syscall(__NR_io_uring_setup, entries, &p);
+	if(_fd < 0 && errno == EINVAL){
+		// older kernel, retry without the optional flags
+		memset(&p, 0, sizeof(p));
+		_fd = syscall(__NR_io_uring_setup, entries, &p);
+	}
+	if(_fd < 0){
+		return -1;
+	}
+	_features = p.features;
+
+	_sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	_cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if(_features & IORING_FEAT_SINGLE_MMAP){
+		if(_cq_ring_size > _sq_ring_size){
+			_sq_ring_size = _cq_ring_size;
+		}
+		_cq_ring_size = _sq_ring_size;
+	}
+
+	_sq_ring = mmap(NULL, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+	if(_sq_ring == MAP_FAILED){
+		return -1;
+	}
+	if(_features & IORING_FEAT_SINGLE_MMAP){
+		_cq_ring = _sq_ring;
+	} else {
+		_cq_ring = mmap(NULL, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+		if(_cq_ring == MAP_FAILED){
+			return -1;
+		}
+	}
+
+	_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	void* sqes = mmap(NULL, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+	if(sqes == MAP_FAILED){
+		return -1;
+	}
+	_sqes = (struct io_uring_sqe*) sqes;
+
+	char* sq = (char*) _sq_ring;
+	_sq_head = (unsigned*)(sq + p.sq_off.head);
+	_sq_tail = (unsigned*)(sq + p.sq_off.tail);
+	_sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+	_sq_array = (unsigned*)(sq + p.sq_off.array);
+	_sq_entries = p.sq_entries;
+
+	char* cq = (char*) _cq_ring;
+	_cq_head = (unsigned*)(cq + p.cq_off.head);
+	_cq_tail = (unsigned*)(cq + p.cq_off.tail);
+	_cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+	_cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+	_sqe_head = _sqe_tail = *_sq_tail;
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: get_sqe
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: struct io_uring_sqe* Uring::get_sqe()
+--
+-- RETURNS:  a zeroed sqe, submitting what is queued first if the submission queue is full
+--
+-- NOTES: The sqe is only handed to the kernel on the next submit().
+----------------------------------------------------------------------------------------------------------------------*/
+struct io_uring_sqe* Uring::get_sqe(){
+	unsigned head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+	if(_sqe_tail - head >= _sq_entries){
+		submit(0);
+		head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+		if(_sqe_tail - head >= _sq_entries){
+			return NULL;
+		}
+	}
+	unsigned idx = _sqe_tail & *_sq_mask;
+	struct io_uring_sqe* sqe = &_sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	_sq_array[idx] = idx;
+	++_sqe_tail;
+	return sqe;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sq_space
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: unsigned Uring::sq_space()
+--
+-- RETURNS:  number of sqes that can be handed out before get_sqe() has to submit
+--
+-- NOTES: Used to keep a linked chain from being split across two submissions.
+----------------------------------------------------------------------------------------------------------------------*/
+unsigned Uring::sq_space(){
+	return _sq_entries - (_sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE));
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: submit
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Uring::submit(unsigned wait_nr)
+--				unsigned wait_nr - number of completions to wait for
+--
+-- RETURNS:  number of sqes submitted, -1 on failure, or -1 with errno EINTR, EAGAIN or EBUSY when the call
+-- should just be made again once the completion queue is drained
+--
+-- NOTES: Publishes every sqe handed out since the last submit and, in the same io_uring_enter call, waits for
+-- completions.  This is the only syscall on the echo path.  Every published sqe the kernel has not consumed
+-- yet is submitted, so the ones a call refused with EAGAIN or EBUSY go in with the next.
+----------------------------------------------------------------------------------------------------------------------*/
+int Uring::submit(unsigned wait_nr){
+	if(_sqe_tail != _sqe_head){
+		__atomic_store_n(_sq_tail, _sqe_tail, __ATOMIC_RELEASE);
+		_sqe_head = _sqe_tail;
+	}
+	unsigned to_submit = _sqe_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+	if(to_submit == 0 && wait_nr == 0){
+		return 0;
+	}
+	unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0;
+	int ret;
+	do {
+		ret = syscall(__NR_io_uring_enter, _fd, to_submit, wait_nr, flags, NULL, 0);
+	} while(ret < 0 && errno == EINTR && wait_nr == 0);
+	if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY){
+		perror("io_uring_enter");
+		return -1;
+	}
+	return ret;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: peek_cqe
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: struct io_uring_cqe* Uring::peek_cqe()
+--
+-- RETURNS:  the oldest unseen completion, NULL if there is none
+--
+-- NOTES: Does not wait.  Call cqe_seen() when done with the returned cqe.
+----------------------------------------------------------------------------------------------------------------------*/
+struct io_uring_cqe* Uring::peek_cqe(){
+	unsigned head = *_cq_head;
+	if(head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE)){
+		return NULL;
+	}
+	return &_cqes[head & *_cq_mask];
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: cqe_seen
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void Uring::cqe_seen()
+--
+-- RETURNS:  void
+--
+-- NOTES: Gives the oldest completion slot back to the kernel.
+----------------------------------------------------------------------------------------------------------------------*/
+void Uring::cqe_seen(){
+	__atomic_store_n(_cq_head, *_cq_head + 1, __ATOMIC_RELEASE);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: register_buf_ring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int Uring::register_buf_ring(struct io_uring_buf_ring* br, unsigned entries, int bgid)
+--				struct io_uring_buf_ring* br - page aligned ring of buffer descriptors
+--				unsigned entries - number of descriptors, a power of two
+--				int bgid - buffer group id recv requests will select from
+--
+-- RETURNS:  0 on success, -1 on failure with errno set
+--
+-- NOTES: Registers a provided buffer ring so the kernel picks a receive buffer when data arrives instead of
+-- the application pinning one per outstanding recv.
+----------------------------------------------------------------------------------------------------------------------*/
+int Uring::register_buf_ring(struct io_uring_buf_ring* br, unsigned entries, int bgid){
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (unsigned long) br;
+	reg.ring_entries = entries;
+	reg.bgid = bgid;
+	int ret = syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &reg, 1);
+	return ret < 0 ? -1 : 0;
+}
@@ -0,0 +1,54 @@
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+
+/**
+minimal io_uring ring: just enough of what liburing does (mmap the rings,
+hand out sqes, submit, reap cqes, register a provided buffer ring) for
+UringServer, using the raw syscalls so the build needs no extra library.
+a ring is used by one thread only.
+*/
+class Uring {
+
+public:
+	Uring();
+	~Uring();
+	Uring(const Uring&) = delete;
+	Uring& operator=(const Uring&) = delete;
+
+	int init(unsigned entries);
+	struct io_uring_sqe* get_sqe();
+	unsigned sq_space();
+	int submit(unsigned wait_nr);
+	struct io_uring_cqe* peek_cqe();
+	void cqe_seen();
+	int register_buf_ring(struct io_uring_buf_ring* br, unsigned entries, int bgid);
+private:
+	int _fd;
+	unsigned _features;
+
+	// submission queue, shared with the kernel
+	unsigned *_sq_head, *_sq_tail, *_sq_mask, *_sq_array;
+	struct io_uring_sqe* _sqes;
+	unsigned _sqe_head, _sqe_tail, _sq_entries;
+
+	// completion queue, shared with the kernel
+	unsigned *_cq_head, *_cq_tail, *_cq_mask;
+	struct io_uring_cqe* _cqes;
+
+	void* _sq_ring;
+	void* _cq_ring;
+	size_t _sq_ring_size, _cq_ring_size, _sqes_size;
+};
+
+#endif
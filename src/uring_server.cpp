@@ -0,0 +1,855 @@
+#include "uring_server.h"
+
+/*------------------------------------------------------------------------------------------------------------------
+-- SOURCE FILE: uring_server.cpp - Hold the code for the io_uring server used by the echo client.
+--
+-- PROGRAM: server
+--
+-- FUNCTIONS: UringServer* UringServer::Instance()
+--			  int UringServer::run()
+--			  int UringServer::create_socket()
+--			  int UringServer::bind_socket(int sd)
+--			  void UringServer::listen_for_clients(int sd)
+--			  int UringServer::set_sock_option(int listenSocket)
+--			  int UringServer::setup_ring(struct uring_worker* w)
+--			  void UringServer::arm_accept(struct uring_worker* w)
+--			  void UringServer::arm_recv(struct uring_worker* w, int fd)
+--			  void UringServer::accept_client(struct uring_worker* w, int fd)
+--			  void UringServer::recycle(struct uring_worker* w, int bid)
+--			  void UringServer::submit_sends(struct uring_worker* w)
+--			  void UringServer::sent(struct uring_worker* w, int fd, uint64_t data, int res)
+--			  void UringServer::close_client(struct uring_worker* w, int fd)
+--			  void * UringServer::process_ring(void * args)
+--			  int UringServer::set_port(int port)
+--			  int UringServer::set_num_threads(int num)
+--			  int UringServer::setBufLen(int buflen)
+--			  int UringServer::set_backlog(int backlog)
+--
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- NOTES: Completion based server.  Every thread owns an io_uring with a multishot accept on its own listen
+-- socket and a multishot recv per connection that picks buffers from a provided buffer ring.  Received buffers
+-- are echoed straight back with linked sends, and go back to the buffer ring once the send completes.  All
+-- the sqes produced while handling a batch of completions go to the kernel in the same io_uring_enter that
+-- waits for the next batch.
+----------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: Instance
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: UringServer* UringServer::Instance()
+--
+-- RETURNS:  Returns the instance of class generated.
+--
+-- NOTES: Creates an instance of io_uring server.
+----------------------------------------------------------------------------------------------------------------------*/
+UringServer* UringServer::Instance()
+{
+	static UringServer m_pInstance;
+
+	return &m_pInstance;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: run
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::run()
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Main io_uring server function.  Opens one listen socket per ring, starts the ring threads and waits
+-- on them.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::run() {
+	if(_numThreads < 1){
+		_numThreads = 1;
+	}
+
+	for(int i = 0; i < _numThreads; i++)
+	{
+		struct uring_worker* w = new uring_worker();
+		w->id = i;
+		w->listen_fd = create_socket();
+		set_sock_option(w->listen_fd);
+		bind_socket(w->listen_fd);
+		listen_for_clients(w->listen_fd);
+		workers.push_back(w);
+	}
+	for(int i = 0; i < _numThreads; i++)
+	{
+		pthread_create(&workers[i]->tid, NULL, process_ring, (void*)workers[i]);
+	}
+	for(int i = 0; i < _numThreads; i++)
+	{
+		pthread_join(workers[i]->tid, NULL);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: create_socket
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::create_socket()
+--
+-- RETURNS:  Socket Descriptor
+--
+-- NOTES: Creates a socket and returns the socket descriptor on successful creation.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::create_socket()
+{
+	int sd;
+	// Create the socket
+	if ((sd = socket(AF_INET, SOCK_STREAM, 0)) == -1)
+	{
+		perror("Cannot create socket");
+		exit(1);
+	}
+	return sd;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: bind_socket
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::bind_socket(int sd)
+--					int sd - listen socket of one ring
+--
+-- RETURNS:  Server Socket Descriptor
+--
+-- NOTES: Function that binds an address to a listen socket and returns it.  Every ring binds the same port.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::bind_socket(int sd)
+{
+	struct	sockaddr_in server;
+
+	// Bind an address to the socket
+	bzero((char *)&server, sizeof(struct sockaddr_in));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(_port);
+	server.sin_addr.s_addr = htonl(INADDR_ANY); // Accept connections from any client
+
+	if (bind(sd, (struct sockaddr *)&server, sizeof(server)) == -1)
+	{
+		perror("Can't bind name to socket");
+		exit(1);
+	}
+	return sd;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: listen_for_clients
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::listen_for_clients(int sd)
+--					int sd - listen socket of one ring
+--
+-- RETURNS:  void
+--
+-- NOTES: Sets the number of clients the server will handle requests to.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::listen_for_clients(int sd)
+{
+	// Listen for connections
+
+	listen(sd, _backlog);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_sock_option
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::set_sock_option(int listenSocket)
+--					       int listenSocket - listening socket
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Function that sets the listening socket options.  SO_REUSEPORT lets every ring listen on the port and
+-- has the kernel spread new connections over them.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::set_sock_option(int listenSocket)
+{
+	// Reuse address set
+	int value = 1;
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	// Set buffer length to send or receive to _buflen.
+	value = _buflen;
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	if (setsockopt (listenSocket, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value)) == -1)
+		perror("setsockopt failed\n");
+
+	return listenSocket;
+
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setup_ring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::setup_ring(struct uring_worker* w)
+--					struct uring_worker* w - ring to set up
+--
+-- RETURNS:  0 on success, -1 on failure
+--
+-- NOTES: Creates the ring, registers its provided buffer ring (buffer group id = ring id) and hands the
+-- kernel every receive buffer.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::setup_ring(struct uring_worker* w)
+{
+	if(w->ring.init(URING_ENTRIES) < 0){
+		perror("io_uring_setup");
+		return -1;
+	}
+
+	size_t size = URING_BUFFERS * sizeof(struct io_uring_buf);
+	void* br = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(br == MAP_FAILED){
+		perror("mmap");
+		return -1;
+	}
+	w->br = (struct io_uring_buf_ring*) br;
+	w->bufs = (char*) malloc((size_t) URING_BUFFERS * _buflen);
+	if(w->bufs == NULL){
+		fprintf(stderr, "out of memory for receive buffers\n");
+		return -1;
+	}
+	if(w->ring.register_buf_ring(w->br, URING_BUFFERS, w->id) < 0){
+		perror("io_uring_register buffer ring");
+		return -1;
+	}
+
+	w->br_tail = 0;
+	w->free_bufs = 0;
+	for(int bid = 0; bid < URING_BUFFERS; bid++){
+		recycle(w, bid);
+	}
+	return 0;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: arm_accept
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::arm_accept(struct uring_worker* w)
+--					struct uring_worker* w - ring of the calling thread
+--
+-- RETURNS:  void
+--
+-- NOTES: Queues a multishot accept on the ring's listen socket.  It posts one completion per connection until
+-- the kernel ends it, at which point it is queued again.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::arm_accept(struct uring_worker* w)
+{
+	struct io_uring_sqe* sqe = w->ring.get_sqe();
+	if(sqe == NULL){
+		LOG_WARN("io_uring submission queue full");
+		return;
+	}
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = w->listen_fd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->user_data = URING_DATA(URING_OP_ACCEPT, w->listen_fd, 0, 0);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: arm_recv
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::arm_recv(struct uring_worker* w, int fd)
+--					struct uring_worker* w - ring of the calling thread
+--					int fd - client socket
+--
+-- RETURNS:  void
+--
+-- NOTES: Queues a multishot recv for the client.  The kernel picks a buffer from the ring's buffer group for
+-- every message, so an idle connection holds no buffer.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::arm_recv(struct uring_worker* w, int fd)
+{
+	struct io_uring_sqe* sqe = w->ring.get_sqe();
+	if(sqe == NULL){
+		LOG_WARN("io_uring submission queue full");
+		return;
+	}
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = w->id;
+	sqe->user_data = URING_DATA(URING_OP_RECV, fd, w->conns[fd].gen, 0);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: accept_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::accept_client(struct uring_worker* w, int fd)
+--					struct uring_worker* w - ring of the calling thread
+--					int fd - socket the accept completed with
+--
+-- RETURNS:  void
+--
+-- NOTES: Adds the new client to the list, sets TCP_NODELAY, resets the ring's state for the fd and starts
+-- receiving on it.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::accept_client(struct uring_worker* w, int fd)
+{
+	struct	sockaddr_in client;
+	socklen_t client_len = sizeof(client);
+	char client_addr[INET_ADDRSTRLEN];
+	bzero((char *)&client, sizeof(client));
+	getpeername(fd, (struct sockaddr *)&client, &client_len);
+
+	// every ring accepts, so not inet_ntoa and its static buffer
+	inet_ntop(AF_INET, &client.sin_addr, client_addr, sizeof(client_addr));
+	if(ClientData::Instance()->addClient(fd, client_addr, client.sin_port) < 0){
+		LOG_WARN("Can't add client %d", fd);
+		close(fd);
+		return;
+	}
+	ClientData::Instance()->recordAccept(1);
+	// pipelined echoes must not wait for the client's delayed ACK
+	int nodelay = 1;
+	if(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay)) == -1){
+		perror("setsockopt TCP_NODELAY");
+	}
+
+	if((size_t) fd >= w->conns.size()){
+		w->conns.resize(fd + 1);
+	}
+	struct uring_conn* c = &w->conns[fd];
+	c->gen = ClientData::Instance()->generation(fd);
+	c->inflight = 0;
+	c->dirty = false;
+	c->queued.clear();
+	c->chain.clear();
+	arm_recv(w, fd);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: recycle
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::recycle(struct uring_worker* w, int bid)
+--					struct uring_worker* w - ring of the calling thread
+--					int bid - buffer id
+--
+-- RETURNS:  void
+--
+-- NOTES: Gives a receive buffer back to the kernel by appending it to the provided buffer ring.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::recycle(struct uring_worker* w, int bid)
+{
+	// not br->bufs: in C++ the header's flex array wrapper shifts it off the start of the ring
+	struct io_uring_buf* buf = (struct io_uring_buf*) w->br + (w->br_tail & (URING_BUFFERS - 1));
+	buf->addr = (unsigned long) (w->bufs + (size_t) bid * _buflen);
+	buf->len = _buflen;
+	buf->bid = bid;
+	++w->br_tail;
+	__atomic_store_n(&w->br->tail, w->br_tail, __ATOMIC_RELEASE);
+	++w->free_bufs;
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: submit_sends
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::submit_sends(struct uring_worker* w)
+--					struct uring_worker* w - ring of the calling thread
+--
+-- RETURNS:  void
+--
+-- NOTES: Queues the echoes of every connection that received data in this batch.  A connection's buffers go
+-- out as one chain of linked sends so they reach the socket in order, and a connection only has one chain in
+-- flight; whatever arrives meanwhile waits for the chain to complete.  When the submission queue has no room
+-- left, even after submitting, the chain is cut short and the connections not served stay on the dirty list
+-- for the next batch.  Connections whose recv ran out of buffers are re-armed once a good part of the buffers
+-- is back.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::submit_sends(struct uring_worker* w)
+{
+	size_t kept = 0;
+	for(size_t i = 0; i < w->dirty.size(); i++){
+		int fd = w->dirty[i];
+		struct uring_conn* c = &w->conns[fd];
+		if(c->gen == 0 || c->inflight > 0 || c->queued.empty()){
+			c->dirty = false;
+			continue;
+		}
+
+		int n = c->queued.size() < URING_MAX_CHAIN ? c->queued.size() : URING_MAX_CHAIN;
+		// a chain split over two submissions would lose its ordering, so get_sqe() must not have to submit
+		if(w->ring.sq_space() < (unsigned) n){
+			w->ring.submit(0);
+			if(w->ring.sq_space() < (unsigned) n){
+				n = w->ring.sq_space();
+			}
+		}
+		struct io_uring_sqe* last = NULL;
+		int j;
+		for(j = 0; j < n; j++){
+			struct io_uring_sqe* sqe = w->ring.get_sqe();
+			if(sqe == NULL){
+				break;
+			}
+			struct uring_send* s = &c->queued[j];
+			sqe->opcode = IORING_OP_SEND;
+			sqe->fd = fd;
+			sqe->addr = (unsigned long) (w->bufs + (size_t) s->bid * _buflen + s->off);
+			sqe->len = s->len - s->off;
+			sqe->msg_flags = MSG_WAITALL | MSG_NOSIGNAL;
+			sqe->flags = IOSQE_IO_LINK;
+			sqe->user_data = URING_DATA(URING_OP_SEND, fd, c->gen, s->bid);
+			s->back = false;
+			last = sqe;
+		}
+		if(last == NULL){
+			// no room at all, try again after the next io_uring_enter
+			w->dirty[kept++] = fd;
+			continue;
+		}
+		last->flags = 0;
+		c->dirty = false;
+		c->inflight = j;
+		c->chain.assign(c->queued.begin(), c->queued.begin() + j);
+		c->queued.erase(c->queued.begin(), c->queued.begin() + j);
+	}
+	w->dirty.resize(kept);
+
+	if(!w->starved.empty() && w->free_bufs >= URING_BUFFERS / 4){
+		for(size_t i = 0; i < w->starved.size(); i++){
+			int fd = URING_FD(w->starved[i]);
+			uint32_t gen = w->conns[fd].gen;
+			// skip connections closed while waiting, even if the fd is in use again
+			if(gen != 0 && (gen & 0x3fffff) == URING_GEN(w->starved[i])){
+				arm_recv(w, fd);
+			}
+		}
+		w->starved.clear();
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: sent
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::sent(struct uring_worker* w, int fd, uint64_t data, int res)
+--					struct uring_worker* w - ring of the calling thread
+--					int fd - client socket
+--					uint64_t data - user_data of the send
+--					int res - result of the send
+--
+-- RETURNS:  void
+--
+-- NOTES: Handles the completion of one send of a chain.  A send that went out in full gives its buffer back.  A
+-- short send breaks the chain, and the sends after it complete with -ECANCELED; once the whole chain is back,
+-- whatever it did not send goes to the front of the queue, in order, and is sent again.  Any other error
+-- closes the connection.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::sent(struct uring_worker* w, int fd, uint64_t data, int res)
+{
+	struct uring_conn* c = &w->conns[fd];
+	if(c->gen == 0 || (c->gen & 0x3fffff) != URING_GEN(data)){
+		// completion for a connection that is already closed
+		recycle(w, URING_BID(data));
+		return;
+	}
+	struct uring_send* s = NULL;
+	for(size_t i = 0; i < c->chain.size() && s == NULL; i++){
+		if(c->chain[i].bid == URING_BID(data) && !c->chain[i].back){
+			s = &c->chain[i];
+		}
+	}
+	if(s == NULL){
+		LOG_WARN("send completion for a buffer socket %d did not send", fd);
+		recycle(w, URING_BID(data));
+		return;
+	}
+	s->back = true;
+	--c->inflight;
+	if(res < 0 && res != -ECANCELED){
+		close_client(w, fd);
+		return;
+	}
+	if(res > 0){
+		s->off += res;
+		ClientData::Instance()->recordData(fd, res);
+	}
+	if(s->off == s->len){
+		recycle(w, s->bid);
+	}
+	if(c->inflight > 0){
+		return;
+	}
+	size_t unsent = 0;
+	for(size_t i = 0; i < c->chain.size(); i++){
+		if(c->chain[i].off < c->chain[i].len){
+			c->chain[unsent++] = c->chain[i];
+		}
+	}
+	c->queued.insert(c->queued.begin(), c->chain.begin(), c->chain.begin() + unsent);
+	c->chain.clear();
+	if(!c->queued.empty() && !c->dirty){
+		c->dirty = true;
+		w->dirty.push_back(fd);
+	}
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: close_client
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void UringServer::close_client(struct uring_worker* w, int fd)
+--					struct uring_worker* w - ring of the calling thread
+--					int fd - client socket
+--
+-- RETURNS:  void
+--
+-- NOTES: Removes the client and closes its socket.  The socket is shut down first so the multishot recv and
+-- any sends still in flight complete; their completions no longer match the connection and only give their
+-- buffers back.
+----------------------------------------------------------------------------------------------------------------------*/
+void UringServer::close_client(struct uring_worker* w, int fd)
+{
+	struct uring_conn* c = &w->conns[fd];
+	if(c->gen == 0){
+		return;
+	}
+	c->gen = 0;
+	for(size_t i = 0; i < c->queued.size(); i++){
+		recycle(w, c->queued[i].bid);
+	}
+	c->queued.clear();
+	// sends still in flight give their buffers back when they complete
+	for(size_t i = 0; i < c->chain.size(); i++){
+		if(c->chain[i].back && c->chain[i].off < c->chain[i].len){
+			recycle(w, c->chain[i].bid);
+		}
+	}
+	c->chain.clear();
+
+	shutdown(fd, SHUT_RDWR);
+	ClientData::Instance()->removeClient(fd);
+	close(fd);
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: process_ring
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: void * UringServer::process_ring(void * args)
+--					void * args - the struct uring_worker this thread runs
+--
+-- RETURNS:  0 on success
+--
+-- NOTES: Ring thread.  Sets up its ring, then one io_uring_enter submits everything queued by the last batch and waits for the next
+-- completion, then every available completion is handled before entering again.  Time outside io_uring_enter
+-- counts as busy.
+----------------------------------------------------------------------------------------------------------------------*/
+void * UringServer::process_ring(void * args)
+{
+	struct uring_worker* w = (struct uring_worker*) args;
+	struct io_uring_cqe* cqe;
+	UringServer* mServer = UringServer::Instance();
+
+	// the ring is created here since only the thread that sets it up may submit to it
+	if(mServer->setup_ring(w) < 0){
+		exit(1);
+	}
+	thread_stats* stats = ThreadStats::local();
+	uint64_t busy_since = 0;
+	ThreadStats::set_role("ring", true);
+	mServer->arm_accept(w);
+	while(1){
+		mServer->submit_sends(w);
+		if(busy_since != 0){
+			stat_add(stats->busy_ns, stat_now_ns() - busy_since);
+		}
+		// EAGAIN and EBUSY: the kernel is short of memory or the completion queue overflowed, so drain it
+		// and enter again; the sqes it refused are submitted then
+		if(w->ring.submit(1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY){
+			break;
+		}
+		busy_since = stat_now_ns();
+		ThreadStats::tick(busy_since);
+
+		while((cqe = w->ring.peek_cqe()) != NULL){
+			uint64_t data = cqe->user_data;
+			int res = cqe->res;
+			unsigned flags = cqe->flags;
+			w->ring.cqe_seen();
+
+			int fd = URING_FD(data);
+			switch(URING_OP(data)){
+				// Case 1: New connection, or the multishot accept ended
+				case URING_OP_ACCEPT:
+					if(res >= 0){
+						mServer->accept_client(w, res);
+					} else if(res != -EINTR && res != -ECONNABORTED){
+						LOG_WARN("Can't accept client: %s", strerror(-res));
+					}
+					if(!(flags & IORING_CQE_F_MORE)){
+						mServer->arm_accept(w);
+					}
+					break;
+
+				// Case 2: One of the sockets has read data
+				case URING_OP_RECV: {
+					if(flags & IORING_CQE_F_BUFFER){
+						--w->free_bufs;
+					}
+					struct uring_conn* c = &w->conns[fd];
+					if(c->gen == 0 || (c->gen & 0x3fffff) != URING_GEN(data)){
+						// completion for a connection that is already closed
+						if(flags & IORING_CQE_F_BUFFER){
+							mServer->recycle(w, flags >> IORING_CQE_BUFFER_SHIFT);
+						}
+						break;
+					}
+					if(res > 0){
+						struct uring_send s;
+						s.bid = flags >> IORING_CQE_BUFFER_SHIFT;
+						s.back = false;
+						s.off = 0;
+						s.len = res;
+						ClientData::Instance()->setRtt(fd);
+						c->queued.push_back(s);
+						if(!c->dirty){
+							c->dirty = true;
+							w->dirty.push_back(fd);
+						}
+						if(!(flags & IORING_CQE_F_MORE)){
+							mServer->arm_recv(w, fd);
+						}
+					} else if(res == -ENOBUFS){
+						// every buffer is queued for sending, wait for some to come back
+						w->starved.push_back(data);
+					} else {
+						if(res == 0){
+							LOG_INFO("socket was gracefully closed by other side %d", fd);
+						}
+						mServer->close_client(w, fd);
+					}
+					break;
+				}
+
+				// Case 3: An echo was sent
+				case URING_OP_SEND:
+					mServer->sent(w, fd, data, res);
+					break;
+			}
+		}
+	}
+	return (void*)0;
+
+}
+
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_port
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::set_port(int port)
+--					int port - server port specified
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets server port when starting the server.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::set_port(int port){
+	_port = port;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_num_threads
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::set_num_threads(int num)
+--					int num - number of rings server should use
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets the number of rings (one listen socket and thread each).
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::set_num_threads(int num){
+	_numThreads=num;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: setBufLen
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::setBufLen(int buflen)
+--					int buflen - buffer length
+--
+-- RETURNS:  N/A
+--
+-- NOTES: sets the size of each provided receive buffer
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::setBufLen(int buflen){
+	_buflen = buflen;
+	return 1;
+}
+/*--------------------------------------------------------------------------------------------------------------------
+-- FUNCTION: set_backlog
+--
+-- DATE: 2026/10/18
+--
+-- REVISIONS: (Date and Description)
+--
+-- DESIGNER: Ian Lee, Luke Tao
+--
+-- PROGRAMMER: Ian Lee, Luke Tao
+--
+-- INTERFACE: int UringServer::set_backlog(int backlog)
+--					int backlog - length of the listen queue
+--
+-- RETURNS:  N/A
+--
+-- NOTES: Sets how many pending connections the listen socket queues.  The kernel caps it at somaxconn.
+----------------------------------------------------------------------------------------------------------------------*/
+int UringServer::set_backlog(int backlog){
+	_backlog = backlog;
+	return 1;
+}
@@ -0,0 +1,118 @@
+#ifndef URING_SERVER_H
+#define URING_SERVER_H
+
+#include "client_data.h"
+#include "uring.h"
+
+#include <iostream>
+#include <vector>
+#include <stdio.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <signal.h>
+#include <string.h>
+#include <pthread.h>
+#include <assert.h>
+
+
+#define BUFLEN 255
+#define TCP_PORT 7000
+#define MAXCLIENTS 100000
+#define URING_ENTRIES 4096
+#define URING_BUFFERS 4096		// provided receive buffers per ring, a power of two
+#define URING_MAX_CHAIN 16		// linked sends submitted per connection at a time
+
+// user_data layout: op(4) | generation(22) | buffer id(16) | fd(22)
+#define URING_OP_ACCEPT	1
+#define URING_OP_RECV	2
+#define URING_OP_SEND	3
+#define URING_DATA(op, fd, gen, bid) (((uint64_t)(op) << 60) | ((uint64_t)((gen) & 0x3fffff) << 38) | \
+	((uint64_t)((bid) & 0xffff) << 22) | (uint64_t)((fd) & 0x3fffff))
+#define URING_OP(data)	((int)((data) >> 60))
+#define URING_GEN(data)	((uint32_t)(((data) >> 38) & 0x3fffff))
+#define URING_BID(data)	((int)(((data) >> 22) & 0xffff))
+#define URING_FD(data)	((int)((data) & 0x3fffff))
+
+/**
+a received buffer waiting to be echoed back, or being sent.
+*/
+struct uring_send {
+	uint16_t bid;
+	bool back;				// in the chain: its completion has arrived
+	int off;				// bytes of it already sent
+	int len;
+};
+
+/**
+what a ring knows about one of its connections.  gen is the ClientData
+generation the state belongs to, 0 once the connection is closed, so
+completions for an old connection on a reused fd are recognised.
+*/
+struct uring_conn {
+	uint32_t gen;
+	int inflight;			// sends submitted and not completed yet
+	bool dirty;				// on the ring's dirty list
+	std::vector<struct uring_send> queued;
+	std::vector<struct uring_send> chain;	// the sends submitted last, in order
+};
+
+/**
+one ring per thread.  each thread has its own SO_REUSEPORT listen socket,
+multishot accept on it, and a provided buffer ring its multishot recvs pick
+from.  connections never leave the thread that accepted them.
+*/
+struct uring_worker {
+	pthread_t tid;
+	int id;
+	int listen_fd;
+	Uring ring;
+	struct io_uring_buf_ring* br;
+	char* bufs;
+	uint16_t br_tail;
+	int free_bufs;
+	std::vector<struct uring_conn> conns;
+	std::vector<int> dirty;
+	std::vector<uint64_t> starved;	// recvs that ran out of buffers, as URING_DATA
+};
+
+
+class UringServer {
+
+public:
+	static UringServer* Instance();
+
+
+	int run();
+	int create_socket();
+	int bind_socket(int sd);
+	void listen_for_clients(int sd);
+	int set_sock_option(int listenSocket);
+	int set_port(int port);
+	int set_num_threads(int num);
+	int setBufLen(int buflen);
+	int set_backlog(int backlog);
+	int _buflen;
+private:
+
+	int 	_port, _backlog, _numThreads;
+	static void * process_ring(void * args);
+	int setup_ring(struct uring_worker* w);
+	void arm_accept(struct uring_worker* w);
+	void arm_recv(struct uring_worker* w, int fd);
+	void accept_client(struct uring_worker* w, int fd);
+	void recycle(struct uring_worker* w, int bid);
+	void submit_sends(struct uring_worker* w);
+	void sent(struct uring_worker* w, int fd, uint64_t data, int res);
+	void close_client(struct uring_worker* w, int fd);
+
+	std::vector<struct uring_worker*> workers;
+};
+
+#endif